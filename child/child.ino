@@ -7,9 +7,7 @@
 
 #include <Arduino.h>
 #include <Wire.h>
-#include <AsyncDelay.h>
 #include <FtModules.h>
-#include <RBD_Servo.h>
 #include <SoftwareSerial.h>
 #include <DFRobotDFPlayerMini.h>
 
@@ -29,15 +27,44 @@
 #define DEFAULT_VOLUME		15			// 0-30
 #define FX_TIMEOUT			10
 #define NUMPIXELS1			4
+#define CMD_QUEUE_LENGTH	16			// Power of two, at least one packet of commands
+#define CMD_LENGTH			LED_FRAME_LENGTH	// Longest command
+
+// Timers: one per LED
+
+#define MAX_TIMERS			NLEDS
+#define NO_TIMER			0xff
+
+// LED brightness: bit-angle modulation on Timer1, which runs free at 2 MHz.
+// Bit n of each level is shown for BAM_TICKS << n ticks: 4 ms per frame.
+
+#define BAM_BITS			8
+#define BAM_TICKS			32			// 16 µs
+#define BAM_FRAME_US		(((1 << BAM_BITS) - 1) * BAM_TICKS / 2)
+#define LED_FULL			255
+
+// Servo pulses on OC1B: Timer1 compare B raises and drops the pin in hardware.
+// The pulse width moves towards the target with a trapezoidal speed profile,
+// one step per 20 ms frame.
+
+#define SERVO_MIN_US		544			// 0°
+#define SERVO_MAX_US		2400		// 180°
+#define SERVO_PERIOD_US		20000
+#define SERVO_ACCEL			24			// µs per frame, per frame
+#define SERVO_MAX_SPEED		120			// µs per frame
+
+// A DFPlayer command is 10 bytes at 9600 baud, sent with interrupts off
+
+#define DFPLAYER_CMD_US		11000
 
 // Arduino pins
 
 const byte soundTx = 2;
 const byte soundRx = 3;
-const byte servoDoor = 6;
+const byte rollover3Led = 6;
 const byte feederMotor = 8;
 const byte rolloverSkillLed = 9;
-const byte rollover3Led	= 10;
+const byte servoDoor = 10;					// OC1B
 const byte rollover2Led = 11;
 const byte rollover1Led = 12;
 const byte lights = 13;
@@ -55,22 +82,13 @@ const byte outputs[] = {
 	lights
 };
 
-// Default servo values
-RBD::Servo rbdServo(servoDoor, 544, 2400);
-
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Variables -------------------------------------------------------
 
-uint servoPos = 0;
-bool updateServo = true;
 byte pixBits = 0;
 byte lastPixBits = 0;
 
-// Servo
-
-AsyncDelay servoTimer;
-
 // Sound
 
 SoftwareSerial mySoftwareSerial(soundRx, soundTx);
@@ -78,26 +96,78 @@ DFRobotDFPlayerMini myDFPlayer;
 
 struct sLedData {
 	uint ledIndex;
-	AsyncDelay timer;
 	outState flash;
 	bool state;
+	uint period;
 };
 
-AsyncDelay timers[NLEDS];
+// Timers
+
+ulong timerDue[MAX_TIMERS];
+byte timerHeap[MAX_TIMERS];			// Timer ids, soonest first
+byte timerPos[MAX_TIMERS];			// Where each id is in timerHeap[]
+byte timerCount = 0;
+
+// Servo
+
+volatile uint servoPulse = 0;		// µs, 0 = position unknown
+volatile uint servoTarget;
+volatile uint servoSpeed;
+volatile byte servoFrames = 0;		// Frames left to drive the servo
+
+// Software PWM. bamB[t][n], bamC[t][n] and bamD[t][n] are what ports B, C and
+// D show during bit n. The interrupt handler shows table bamFront while loop()
+// builds the other one, and swaps them at the start of a frame once bamSwap is
+// set.
+
+byte ledLevels[NLEDS];
+byte ledMasks[NLEDS];
+byte ledPorts[NLEDS];
+bool ledsChanged = false;				// ledLevels[] differs from the tables
+byte bamMaskB = 0;
+byte bamMaskC = 0;
+byte bamMaskD = 0;
+volatile byte bamB[2][BAM_BITS];
+volatile byte bamC[2][BAM_BITS];
+volatile byte bamD[2][BAM_BITS];
+volatile byte bamFront = 0;
+volatile bool bamSwap = false;
+volatile byte bamBit = 0;
+volatile byte bamFrames = 0;			// Frames shown since pwmUpdate()
+
+// Fades, one step per frame, in 8.8 fixed point
+
+uint fadeLevels[NLEDS];
+int fadeSteps[NLEDS];
+byte fadeTargets[NLEDS];
+uint fadeFrames[NLEDS];
+
+// Commands received, waiting for loop(). receiveEvent() only moves cmdHead and
+// loop() only moves cmdTail, so neither needs to disable interrupts. Both run
+// free and are masked on use, so every slot can be filled.
+
+// The shortest command takes two bytes of a packet, its length and its code
+
+static_assert(CMD_QUEUE_LENGTH >= CHILD_PACKET_LENGTH / 2, "A packet must fit in an empty queue");
+
+byte cmdQueue[CMD_QUEUE_LENGTH][CMD_LENGTH];
+volatile byte cmdHead = 0;
+volatile byte cmdTail = 0;
+volatile uint cmdOverflows = 0;			// Packets rejected
 
 sLedData ledData[NLEDS] = {
 
 	// LEDs
 
-	{rollover1Led,    	timers[0], outState::OFF, false},
-	{rollover2Led,    	timers[1], outState::OFF, false},
-	{rollover3Led,    	timers[2], outState::OFF, false},
-	{rolloverSkillLed,	timers[3], outState::OFF, false},
-	{holdLed,			timers[5], outState::OFF, false},
-	{rightOutlaneLed,	timers[7], outState::OFF, false},
-	{leftOutlaneLed,	timers[6], outState::OFF, false},
-	{leftOrbitLed,		timers[4], outState::OFF, false},
-	{lights,           	timers[8], outState::OFF, false},
+	{rollover1Led,    	outState::OFF, false, 0},
+	{rollover2Led,    	outState::OFF, false, 0},
+	{rollover3Led,    	outState::OFF, false, 0},
+	{rolloverSkillLed,	outState::OFF, false, 0},
+	{holdLed,			outState::OFF, false, 0},
+	{rightOutlaneLed,	outState::OFF, false, 0},
+	{leftOutlaneLed,	outState::OFF, false, 0},
+	{leftOrbitLed,		outState::OFF, false, 0},
+	{lights,           	outState::OFF, false, 0},
 };
 
 #pragma endregion --------------------------------------------------------------
@@ -111,16 +181,23 @@ void setup()
 	// Serial.begin(BAUDRATE);
 	soundInit();
 
+	for(int i = 0; i < MAX_TIMERS; i++) {
+		timerPos[i] = NO_TIMER;
+	}
+
 	// Set up pin modes
 
 	for(int i = 0; i < sizeof outputs; i++) {
 		pinMode(outputs[i], OUTPUT);
 	}
 
+	pwmInit();
+
 	closeDoor();
 
 	Wire.begin(CHILD_ADDRESS);
 	Wire.onReceive(receiveEvent);
+	Wire.onRequest(requestEvent);
 
 	// Serial.println("Child Arduino is ready");
 }
@@ -131,6 +208,7 @@ void setup()
 
 void loop()
 {
+	processCommands();
 	gameLoop();
 
 	// testServo();
@@ -142,53 +220,136 @@ void loop()
 void gameLoop()
 {
 	checkTimers();
+	pwmUpdate();
+}
 
-	if(servoTimer.isExpired()) {
-		updateServo = false;
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Timer functions -------------------------------------------------
+
+// Timers are kept in a binary heap ordered by due time, so checking them costs
+// one comparison with the soonest, however many there are. Each timer id is
+// either in the heap or not, and timerPos[] tells where.
+
+void timerSet(byte id, ulong due)
+{
+	byte i = timerPos[id];
+
+	if(i == NO_TIMER) {
+		i = timerCount++;
+		timerHeap[i] = id;
+		timerPos[id] = i;
 	}
+	timerDue[id] = due;
+
+	heapUp(heapDown(i));
+}
 
-	if(updateServo) {
-		rbdServo.update();
+void timerCancel(byte id)
+{
+	byte i = timerPos[id];
+
+	if(i == NO_TIMER) {
+		return;
+	}
+
+	timerPos[id] = NO_TIMER;
+	if(i != --timerCount) {
+		timerHeap[i] = timerHeap[timerCount];
+		timerPos[timerHeap[i]] = i;
+		heapUp(heapDown(i));
 	}
 }
 
-#pragma endregion --------------------------------------------------------------
+void checkTimers()
+{
+	ulong ms = millis();
 
-#pragma region Timer functions -------------------------------------------------
+	while(timerCount && (long)(ms - timerDue[timerHeap[0]]) >= 0) {
+		byte id = timerHeap[0];
+		ulong due = timerDue[id];
+		timerCancel(id);
+		timerExpired(id, due);
+	}
+}
+
+// Timers restart from when they were due, not from when they were seen
+
+void timerExpired(byte id, ulong due)
+{
+	sLedData *ld = &ledData[id];
+
+	if(ld->flash == outState::FLASH) {
+		ld->state = !ld->state;
+		setLed(id, ld->state);
+		timerSet(id, due + ld->period);
+	} else if(ld->flash == outState::ONESHOT) {
+		ld->flash = outState::OFF;
+		ld->state = false;
+		setLed(id, false);
+	}
+}
+
+bool timerBefore(byte a, byte b)
+{
+	return (long)(timerDue[timerHeap[a]] - timerDue[timerHeap[b]]) < 0;
+}
+
+void heapSwap(byte a, byte b)
+{
+	byte id = timerHeap[a];
+
+	timerHeap[a] = timerHeap[b];
+	timerHeap[b] = id;
+	timerPos[timerHeap[a]] = a;
+	timerPos[timerHeap[b]] = b;
+}
+
+byte heapDown(byte i)
+{
+	for(;;) {
+		byte child = 2 * i + 1;
+		if(child >= timerCount) {
+			return i;
+		}
+		if(child + 1 < timerCount && timerBefore(child + 1, child)) {
+			child++;
+		}
+		if(!timerBefore(child, i)) {
+			return i;
+		}
+		heapSwap(i, child);
+		i = child;
+	}
+}
+
+void heapUp(byte i)
+{
+	while(i > 0 && timerBefore(i, (i - 1) / 2)) {
+		heapSwap(i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
 
 void startTimer(uint index, ulong ms)
 {
 	ledData[index].flash = outState::FLASH;
 	ledData[index].state = true;
-	ledData[index].timer.start(ms, AsyncDelay::MILLIS);
+	ledData[index].period = ms;
+	timerSet(index, millis() + ms);
 }
 
 void startOneShot(uint index, ulong ms)
 {
 	ledData[index].flash = outState::ONESHOT;
 	ledData[index].state = true;
-	ledData[index].timer.start(ms, AsyncDelay::MILLIS);
-}
-
-void checkTimers()
-{
-	for(int i = 0; i < NLEDS; i++) {
-		if(ledData[i].timer.isExpired() && ledData[i].flash > outState::OFF) {
-			if(ledData[i].flash == outState::FLASH) {
-				ledData[i].state = !ledData[i].state;
-				setLed(i, ledData[i].state);
-				ledData[i].timer.repeat();
-			} else if(ledData[i].flash == outState::ONESHOT) {
-				setLed(i, false);
-			}
-		}
-	}
+	timerSet(index, millis() + ms);
 }
 
 void stopTimer(uint index)
 {
 	if(ledData[index].flash > outState::OFF) {
-		ledData[index].timer.expire();
+		timerCancel(index);
 		ledData[index].flash = outState::OFF;
 		ledData[index].state = false;
 	}
@@ -200,12 +361,42 @@ void stopTimer(uint index)
 
 void setLed(uint index, bool value)
 {
-	sLedData ld = ledData[index];
-	digitalWrite(ld.ledIndex, value);
+	setLevel(index, value ? LED_FULL : 0);
+}
+
+// Shows from the next frame that pwmUpdate() gets to
+
+void setLevel(uint index, byte level)
+{
+	fadeFrames[index] = 0;
+	ledLevels[index] = level;
+	ledsChanged = true;
+}
+
+// Fades from the current level to another in time * 100 ms
+
+void startFade(byte index, byte level, byte time)
+{
+	ulong frames = (ulong)time * 100000UL / BAM_FRAME_US;
+
+	stopTimer(index);
+	if(frames < 2) {
+		setLevel(index, level);
+		return;
+	}
+
+	fadeLevels[index] = (uint)ledLevels[index] << 8;
+	fadeTargets[index] = level;
+	fadeSteps[index] = (((long)level << 8) - (long)fadeLevels[index]) / (long)frames;
+	fadeFrames[index] = frames;
 }
 
 void processLedCmd(byte index, outState cmd, byte time)
 {
+	if(index >= NLEDS) {
+		return;
+	}
+
 	switch(cmd) {
 
 		case outState::ON:
@@ -232,32 +423,229 @@ void processLedCmd(byte index, outState cmd, byte time)
 
 #pragma endregion --------------------------------------------------------------
 
+#pragma region Software PWM ----------------------------------------------------
+
+// The interrupt handler only copies precomputed port values, so it stays
+// short and the LEDs do not flicker whatever the main loop is doing. Fades and
+// the tables are worked out in loop(); a slow pass only delays a change.
+// Timer1 also times the servo pulses; see servoMoveTo().
+
+void pwmInit()
+{
+	for(int i = 0; i < NLEDS; i++) {
+		byte pin = ledData[i].ledIndex;
+		ledMasks[i] = digitalPinToBitMask(pin);
+		ledPorts[i] = digitalPinToPort(pin);
+		switch(ledPorts[i]) {
+			case PB:
+				bamMaskB |= ledMasks[i];
+				break;
+			case PC:
+				bamMaskC |= ledMasks[i];
+				break;
+			case PD:
+				bamMaskD |= ledMasks[i];
+				break;
+		}
+	}
+	pwmBuild(bamFront);
+
+	TCCR1A = 0;
+	TCCR1B = bit(CS11);						// Prescaler 8
+	OCR1A = TCNT1 + BAM_TICKS;
+	TIMSK1 |= bit(OCIE1A);
+}
+
+// Called from loop() once per pass: steps the fades by the frames shown since
+// the last call, then builds the back table if it is free
+
+void pwmUpdate()
+{
+	byte frames;
+
+	noInterrupts();
+	frames = bamFrames;
+	bamFrames = 0;
+	interrupts();
+
+	if(frames) {
+		fadeStep(frames);
+	}
+
+	if(ledsChanged && !bamSwap) {
+		ledsChanged = false;
+		pwmBuild(bamFront ^ 1);
+		bamSwap = true;
+	}
+}
+
+// The interrupt handler does not read table t
+
+void pwmBuild(byte t)
+{
+	for(byte n = 0; n < BAM_BITS; n++) {
+		byte b = 0;
+		byte c = 0;
+		byte d = 0;
+		for(byte i = 0; i < NLEDS; i++) {
+			if(ledLevels[i] & bit(n)) {
+				switch(ledPorts[i]) {
+					case PB:
+						b |= ledMasks[i];
+						break;
+					case PC:
+						c |= ledMasks[i];
+						break;
+					case PD:
+						d |= ledMasks[i];
+						break;
+				}
+			}
+		}
+		bamB[t][n] = b;
+		bamC[t][n] = c;
+		bamD[t][n] = d;
+	}
+}
+
+// Frames missed by a slow pass are made up at once, so fades keep their time
+
+void fadeStep(byte frames)
+{
+	for(byte i = 0; i < NLEDS; i++) {
+		if(fadeFrames[i]) {
+			uint n = frames < fadeFrames[i] ? frames : fadeFrames[i];
+			fadeLevels[i] += (uint)fadeSteps[i] * n;
+			fadeFrames[i] -= n;
+			ledLevels[i] = fadeFrames[i] ? highByte(fadeLevels[i]) : fadeTargets[i];
+			ledsChanged = true;
+		}
+	}
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+	byte n = bamBit;
+
+	if(n == 0 && bamSwap) {
+		bamFront ^= 1;
+		bamSwap = false;
+	}
+
+	byte t = bamFront;
+
+	PORTB = (PORTB & ~bamMaskB) | bamB[t][n];
+	PORTC = (PORTC & ~bamMaskC) | bamC[t][n];
+	PORTD = (PORTD & ~bamMaskD) | bamD[t][n];
+	OCR1A += BAM_TICKS << n;
+	n = (n + 1) & (BAM_BITS - 1);
+
+	// Held up past the next compare, as by SoftwareSerial or the TWI handler,
+	// Timer1 would wrap before matching and freeze the LEDs for 32 ms. The
+	// frame starts over from bit 0 instead.
+
+	if((int)(OCR1A - TCNT1) <= 0) {
+		OCR1A = TCNT1 + BAM_TICKS;
+		n = 0;
+	}
+
+	if(n == 0 && bamFrames < 0xff) {
+		bamFrames++;
+	}
+	bamBit = n;
+}
+
+#pragma endregion --------------------------------------------------------------
+
 #pragma region I²C functions ---------------------------------------------------
 
+// Runs in the TWI interrupt: only queues the commands. Sound, in particular,
+// goes out over SoftwareSerial and would keep interrupts off for milliseconds.
+
+// A packet holds one or more commands, each preceded by its length. Parsing
+// stops at the first one that does not fit in what was received. A packet is
+// queued whole or not at all, and counted when it is not; the primary reads
+// the count and forgets what it thinks the outputs are.
+
 void receiveEvent(int nBytes)
 {
-	byte cmd[BUFFER_LENGTH];
+	byte packet[CHILD_PACKET_LENGTH];
+	int n = 0;
+	byte count = 0;
+	int end = 0;
+
+	while(Wire.available()) {
+		byte value = Wire.read();
+		if(n < nBytes && n < CHILD_PACKET_LENGTH) {
+			packet[n++] = value;
+		}
+	}
 
-	// Serial.print("Command: ");
+	while(end < n && packet[end] != 0 && packet[end] < n - end) {
+		end += packet[end] + 1;
+		count++;
+	}
 
-	for(int count = 0; count < BUFFER_LENGTH; count++) {
-		bool available = Wire.available();
-		cmd[count] = available ? Wire.read() : '\x0';
-		// if(available) {
-		// 	Serial.print((byte)cmd[count]);
-		// 	Serial.print(" ");
-		// }
+	if((byte)(cmdHead - cmdTail) + count > CMD_QUEUE_LENGTH) {
+		cmdOverflows++;
+		return;
 	}
 
-	// Serial.println("");
+	for(int i = 0; i < end; i += packet[i] + 1) {
+		queueCommand(packet + i + 1, packet[i]);
+	}
+}
+
+// Missing arguments read as zero. The caller makes room.
+
+void queueCommand(const byte *data, byte length)
+{
+	byte *cmd = cmdQueue[cmdHead & (CMD_QUEUE_LENGTH - 1)];
+
+	for(int count = 0; count < CMD_LENGTH; count++) {
+		cmd[count] = count < length ? data[count] : '\x0';
+	}
+
+	cmdHead++;
+}
+
+// The primary reads the overflow count now and then
+
+void requestEvent()
+{
+	uint overflows = cmdOverflows;
+
+	Wire.write(lowByte(overflows));
+	Wire.write(highByte(overflows));
+}
+
+// Commands that talk to the DFPlayer wait for a gap between servo pulses
 
-	// Received commands
+void processCommands()
+{
+	while(cmdTail != cmdHead) {
+		byte *cmd = cmdQueue[cmdTail & (CMD_QUEUE_LENGTH - 1)];
+		bool sound = cmd[0] == (byte)childCommands::SOUND || cmd[0] == (byte)childCommands::RESET;
+
+		if(sound && !servoQuiet()) {
+			return;
+		}
+		executeCommand(cmd);
+		cmdTail++;
+	}
+}
+
+void executeCommand(byte *cmd)
+{
+	// Serial.print("Command: ");
+	// Serial.println((byte)cmd[0]);
 
 	switch((byte)cmd[0]) {
 
 		case (byte)childCommands::RESET:
-			for(int i = 0; i < sizeof outputs; i++) {
- 				digitalWrite(outputs[i], outputs[i] == lights ? HIGH : LOW);
+			digitalWrite(feederMotor, LOW);
+			for(int i = 0; i < NLEDS; i++) {
+				processLedCmd(i, ledData[i].ledIndex == lights ? outState::ON : outState::OFF, 0);
 			}
 			myDFPlayer.stop();
 			break;
@@ -288,6 +676,20 @@ void receiveEvent(int nBytes)
 		case (byte)childCommands::MOTOR:
 			digitalWrite(feederMotor, cmd[1] ? HIGH : LOW);
 			break;
+
+		case (byte)childCommands::LED_FADE:
+			if(cmd[1] < NLEDS) {
+				startFade(cmd[1], cmd[2], cmd[3]);
+			}
+			break;
+
+		case (byte)childCommands::LED_FRAME:
+			for(int i = 0; i < NLEDS; i++) {
+				if(cmd[1 + 2 * i] != LED_KEEP) {
+					processLedCmd(i, (outState)cmd[1 + 2 * i], cmd[2 + 2 * i]);
+				}
+			}
+			break;
 	}
 }
 
@@ -310,6 +712,12 @@ void soundInit()
 	myDFPlayer.setTimeOut(FX_TIMEOUT);
 	myDFPlayer.volume(DEFAULT_VOLUME);
 	myDFPlayer.EQ(0);
+
+	// Nothing is read back from now on, so replies cannot raise the
+	// SoftwareSerial receive interrupt in the middle of a servo pulse
+
+	myDFPlayer.disableACK();
+	mySoftwareSerial.stopListening();
 }
 
 #pragma endregion --------------------------------------------------------------
@@ -318,16 +726,96 @@ void soundInit()
 
 void openDoor()
 {
-	updateServo = true;
-	rbdServo.moveToDegrees(OPEN_DOOR);
-	servoTimer.start(SERVO_TIMER, AsyncDelay::MILLIS);
+	servoMoveTo(OPEN_DOOR);
 }
 
 void closeDoor()
 {
-	updateServo = true;
-	rbdServo.moveToDegrees(CLOSED_DOOR);
-	servoTimer.start(SERVO_TIMER, AsyncDelay::MILLIS);
+	servoMoveTo(CLOSED_DOOR);
+}
+
+// The servo is driven for SERVO_TIMER ms, then left alone until the next move
+
+void servoMoveTo(uint degrees)
+{
+	uint pulse = SERVO_MIN_US + (ulong)degrees * (SERVO_MAX_US - SERVO_MIN_US) / 180;
+
+	noInterrupts();
+	servoTarget = pulse;
+	if(!servoPulse) {
+		servoPulse = pulse;
+	}
+	servoSpeed = 0;
+	servoFrames = SERVO_TIMER * 1000UL / SERVO_PERIOD_US;
+	if(!(TIMSK1 & bit(OCIE1B))) {
+		OCR1B = TCNT1 + 2 * SERVO_MIN_US;
+		TCCR1A |= bit(COM1B1) | bit(COM1B0);	// Set OC1B on the next match
+		TIFR1 = bit(OCF1B);
+		TIMSK1 |= bit(OCIE1B);
+	}
+	interrupts();
+}
+
+// True if a DFPlayer command sent now ends before the next servo pulse.
+// SoftwareSerial keeps interrupts off for ~1 ms per byte, longer than the
+// shortest pulse, so the compare B handler could load the end of a pulse late.
+
+bool servoQuiet()
+{
+	bool quiet;
+
+	noInterrupts();
+	quiet = !(TIMSK1 & bit(OCIE1B)) ||
+		((TCCR1A & bit(COM1B0)) && (uint)(OCR1B - TCNT1) > 2 * DFPLAYER_CMD_US);
+	interrupts();
+
+	return quiet;
+}
+
+// Speeds up to SERVO_MAX_SPEED, and slows down in time to stop on the target
+
+void servoProfile()
+{
+	uint distance = servoTarget > servoPulse ? servoTarget - servoPulse : servoPulse - servoTarget;
+	uint speed = servoSpeed;
+
+	if(speed * speed / (2 * SERVO_ACCEL) >= distance) {
+		speed = speed > SERVO_ACCEL ? speed - SERVO_ACCEL : SERVO_ACCEL;
+	} else if(speed < SERVO_MAX_SPEED) {
+		speed += SERVO_ACCEL;
+	}
+	if(speed > distance) {
+		speed = distance;
+	}
+
+	servoSpeed = speed;
+	servoPulse = servoTarget > servoPulse ? servoPulse + speed : servoPulse - speed;
+}
+
+// Timer1 ticks are 0.5 µs. The pin has already changed when this runs; it
+// only loads the next edge, and has the whole pulse (at least 544 µs) or gap
+// to do it. Other interrupts hold it off for far less than that.
+
+ISR(TIMER1_COMPB_vect)
+{
+	if(TCCR1A & bit(COM1B0)) {
+
+		// The pulse has started: clear OC1B at its end
+
+		TCCR1A &= ~bit(COM1B0);
+		OCR1B += 2 * servoPulse;
+		servoFrames--;
+	} else if(servoFrames) {
+
+		// The pulse has ended: set OC1B at the start of the next one
+
+		TCCR1A |= bit(COM1B0);
+		OCR1B += 2 * (SERVO_PERIOD_US - servoPulse);
+		servoProfile();
+	} else {
+		TCCR1A &= ~(bit(COM1B1) | bit(COM1B0));
+		TIMSK1 &= ~bit(OCIE1B);
+	}
 }
 
 #pragma endregion --------------------------------------------------------------
@@ -361,13 +849,11 @@ void testServo()
 	ulong ms = millis();
 
 	if(ms > tsLast + 2000) {
-		rbdServo.moveToDegrees(tsOpen ? OPEN_DOOR : CLOSED_DOOR);
+		servoMoveTo(tsOpen ? OPEN_DOOR : CLOSED_DOOR);
 		// Serial.println(tsOpen ? "open" : "closed");
 		tsOpen = !tsOpen;
 		tsLast = ms;
 	}
-
-	rbdServo.update();
 }
 
 uint cLed = 0;
@@ -0,0 +1,157 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Serial telemetry decoder
+// Rubem Pechansky 2021
+
+// Reads the primary's serial output and writes it back as text: frames (see
+// pinball/telemetry.h) become one timestamped line each, everything else is
+// passed through.
+
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "telemetry.h"
+
+// Same order as gameStates
+
+const char *stateNames[] = {
+	"Game start", "Ball start", "Launching", "Playing", "No more points",
+	"Ball lost", "Save ball", "Next ball", "Ball near home", "Game over"
+};
+
+static_assert(NUMITEMS(stateNames) == NGAMESTATES, "stateNames[] must have one entry per game state");
+
+#pragma region Input -----------------------------------------------------------
+
+// Enough lookahead for one frame
+
+byte window[TELEMETRY_PAYLOAD + TELEMETRY_OVERHEAD];
+int windowLength = 0;
+bool atEof = false;
+
+bool fill(int n)
+{
+	while(windowLength < n && !atEof) {
+		int c = getchar();
+		if(c == EOF) {
+			atEof = true;
+		} else {
+			window[windowLength++] = c;
+		}
+	}
+	return windowLength >= n;
+}
+
+void consume(int n)
+{
+	for(int i = n; i < windowLength; i++) {
+		window[i - n] = window[i];
+	}
+	windowLength -= n;
+}
+
+// Length of the frame at the start of the window, or 0 if there is none
+
+int frameLength()
+{
+	byte sum = 0;
+
+	if(!fill(TELEMETRY_OVERHEAD) || window[0] != TELEMETRY_SYNC || window[4] > TELEMETRY_PAYLOAD) {
+		return 0;
+	}
+
+	int length = window[4] + TELEMETRY_OVERHEAD;
+	if(!fill(length)) {
+		return 0;
+	}
+
+	for(int i = 1; i < length - 1; i++) {
+		sum += window[i];
+	}
+	return sum == window[length - 1] ? length : 0;
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Output ----------------------------------------------------------
+
+void printEvent(double seconds, const byte *frame)
+{
+	byte n = frame[4];
+	const byte *payload = &frame[5];
+
+	printf("[%9.3f] ", seconds);
+
+	switch((telemetryEvents)frame[1]) {
+
+		case telemetryEvents::GAME_STATE:
+			if(n == 1 && payload[0] >= 1 && payload[0] <= NGAMESTATES) {
+				printf("gameState: %s\n", stateNames[payload[0] - 1]);
+			} else {
+				printf("gameState: unknown\n");
+			}
+			break;
+
+		case telemetryEvents::LAUNCHED:
+			printf("Launched, seen by %s\n", n == 1 && payload[0] ? "the launch sensor" : "another sensor");
+			break;
+
+		case telemetryEvents::FEEDER_TIMEOUT:
+			printf("Feeder timeout\n");
+			break;
+
+		default:
+			printf("Event %u,", frame[1]);
+			for(byte i = 0; i < n; i++) {
+				printf(" %02x", payload[i]);
+			}
+			printf("\n");
+			break;
+	}
+}
+
+#pragma endregion --------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	bool atLineStart = true;
+	uint64_t ms = 0;
+	uint lastStamp = 0;
+	bool started = false;
+
+	if(argc > 1) {
+		fprintf(stderr, "Usage: pinball-decode < serial.log\n");
+		return 2;
+	}
+
+	while(fill(1)) {
+		int length = frameLength();
+
+		if(length) {
+
+			// The 16-bit timestamp wraps every 65.5 s; longer silences are lost
+
+			uint stamp = window[2] | window[3] << 8;
+			ms += started ? (uint16_t)(stamp - lastStamp) : stamp;
+			lastStamp = stamp;
+			started = true;
+
+			if(!atLineStart) {
+				putchar('\n');
+				atLineStart = true;
+			}
+			printEvent(ms / 1000.0, window);
+			consume(length);
+		} else {
+			if(window[0] != '\r') {
+				putchar(window[0]);
+				atLineStart = window[0] == '\n';
+			}
+			consume(1);
+		}
+	}
+
+	return 0;
+}
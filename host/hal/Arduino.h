@@ -0,0 +1,214 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host stand-in for the Arduino core
+// Rubem Pechansky 2021
+
+// Only what the primary firmware uses. Time is virtual: see hal.h.
+
+// -----------------------------------------------------------------------------
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Constants
+
+#define HIGH				1
+#define LOW					0
+
+#define INPUT				0
+#define OUTPUT				1
+#define INPUT_PULLUP		2
+
+#define F_CPU				16000000UL
+
+#define DEC					10
+#define HEX					16
+
+// Arduino Nano pin numbers
+
+#define A0					14
+#define A1					15
+#define A2					16
+#define A3					17
+#define A4					18
+#define A5					19
+#define A6					20
+#define A7					21
+
+#define NUM_PINS			(A7 + 1)
+
+#define SDA					A4
+#define SCL					A5
+
+// Port input registers
+
+#define PIND				hostPortInput(0)
+#define PINB				hostPortInput(8)
+#define PINC				hostPortInput(A0)
+
+// Pin change interrupt registers
+
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCIFR;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+
+#define PCIE0				0
+#define PCIE1				1
+#define PCIE2				2
+#define PCIF0				0
+#define PCIF1				1
+#define PCIF2				2
+
+#define PCINT8				0
+#define PCINT9				1
+#define PCINT10				2
+#define PCINT11				3
+#define PCINT12				4
+#define PCINT13				5
+
+// External interrupt registers (INT0 on pin 2, INT1 on pin 3)
+
+extern volatile uint8_t EICRA;
+extern volatile uint8_t EIMSK;
+extern volatile uint8_t EIFR;
+
+#define ISC00				0
+#define ISC01				1
+#define ISC10				2
+#define ISC11				3
+#define INT0				0
+#define INT1				1
+#define INTF0				0
+#define INTF1				1
+
+// Timer0 compare A. Timer0 also runs millis(), so only its interrupt, once
+// per 1024 µs, is emulated.
+
+extern volatile uint8_t TIMSK0;
+extern volatile uint8_t TIFR0;
+extern volatile uint8_t OCR0A;
+
+#define OCIE0A				1
+#define OCF0A				1
+
+// ADC registers. Only free-running, interrupt-driven conversions are emulated.
+
+extern volatile uint8_t ADMUX;
+extern volatile uint8_t ADCSRA;
+extern volatile uint8_t ADCSRB;
+extern volatile uint16_t ADC;
+
+#define REFS0				6
+#define ADEN				7
+#define ADSC				6
+#define ADATE				5
+#define ADIF				4
+#define ADIE				3
+#define ADPS2				2
+#define ADPS1				1
+#define ADPS0				0
+
+// TWI registers. Writing TWCR starts what it asks for, as on the target, so it
+// is an object rather than a plain variable.
+
+extern volatile uint8_t TWBR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWDR;
+
+class hostTwcr
+{
+  public:
+	hostTwcr &operator=(uint8_t value);
+	operator uint8_t() const;
+};
+
+extern hostTwcr TWCR;
+
+#define TWINT				7
+#define TWEA				6
+#define TWSTA				5
+#define TWSTO				4
+#define TWWC				3
+#define TWEN				2
+#define TWIE				0
+
+// Interrupts. The HAL calls handlers from the virtual clock, never nested
+// and never while interrupts are disabled.
+
+#define ISR(vector)			void vector()
+
+void noInterrupts();
+void interrupts();
+
+// Strings in flash
+
+class __FlashStringHelper;
+
+#define F(s)				(reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+
+// Macros
+
+#define bit(b)				(1UL << (b))
+#define lowByte(w)			((uint8_t)((w) & 0xff))
+#define highByte(w)			((uint8_t)((w) >> 8))
+
+// Core functions
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+uint8_t hostPortInput(uint8_t firstPin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Serial port
+
+class HardwareSerial
+{
+  public:
+	void begin(unsigned long baud);
+	int available();
+	int read();
+
+	int availableForWrite();
+	size_t write(uint8_t c);
+	size_t write(const uint8_t *buffer, size_t size);
+	size_t print(const char *str);
+	size_t print(const __FlashStringHelper *str);
+	size_t print(char c);
+	size_t print(int n, int base = DEC);
+	size_t print(unsigned int n, int base = DEC);
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+	size_t println();
+	size_t println(const char *str);
+	size_t println(const __FlashStringHelper *str);
+	size_t println(char c);
+	size_t println(int n, int base = DEC);
+	size_t println(unsigned int n, int base = DEC);
+	size_t println(long n, int base = DEC);
+	size_t println(unsigned long n, int base = DEC);
+
+  private:
+	size_t printNumber(unsigned long n, int base);
+};
+
+extern HardwareSerial Serial;
+
+#endif // Arduino_h
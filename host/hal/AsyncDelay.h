@@ -0,0 +1,57 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host stand-in for the AsyncDelay library
+// Rubem Pechansky 2021
+
+// Same interface and wrap-around semantics as the Arduino library.
+
+// -----------------------------------------------------------------------------
+
+#ifndef AsyncDelay_h
+#define AsyncDelay_h
+
+#include <Arduino.h>
+
+class AsyncDelay
+{
+  public:
+	enum units_t
+	{
+		MICROS,
+		MILLIS,
+	};
+
+	AsyncDelay() : _delay(0), _unit(MILLIS) { _expires = millis(); }
+
+	AsyncDelay(unsigned long delay, units_t unit) { start(delay, unit); }
+
+	void start(unsigned long delay, units_t unit)
+	{
+		_delay = delay;
+		_unit = unit;
+		_expires = now() + delay;
+	}
+
+	void expire() { _expires = now(); }
+
+	void repeat() { _expires += _delay; }
+
+	void restart() { _expires = now() + _delay; }
+
+	bool isExpired() const { return (long)(now() - _expires) >= 0; }
+
+	unsigned long getExpiry() const { return _expires; }
+
+	unsigned long getDelay() const { return _delay; }
+
+	units_t getUnit() const { return _unit; }
+
+  private:
+	unsigned long now() const { return _unit == MICROS ? micros() : millis(); }
+
+	unsigned long _delay;
+	unsigned long _expires;
+	units_t _unit;
+};
+
+#endif // AsyncDelay_h
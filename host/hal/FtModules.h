@@ -0,0 +1,30 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host stand-in for FtModules.h (ft-modules-lib)
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#ifndef FtModules_h
+#define FtModules_h
+
+#include <Arduino.h>
+
+namespace FtModules
+{
+	namespace SevenSegDisplay
+	{
+		enum commands
+		{
+			cmdBlank = 1,
+			cmdTest,
+			cmdDisplay,
+			cmdHold,
+			cmdFlash,
+			cmdRotate,
+			cmdStop,
+		};
+	}
+}
+
+#endif // FtModules_h
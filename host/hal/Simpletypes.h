@@ -0,0 +1,16 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host stand-in for Simpletypes.h (ft-modules-lib)
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#ifndef Simpletypes_h
+#define Simpletypes_h
+
+typedef unsigned int uint;
+typedef unsigned long ulong;
+
+#define NUMITEMS(arg)		(sizeof(arg) / sizeof(arg[0]))
+
+#endif // Simpletypes_h
@@ -0,0 +1,31 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host stand-in for avr-libc avr/pgmspace.h
+// Rubem Pechansky 2021
+
+// The host has one address space, so flash data is ordinary const data and
+// the _P functions are their plain counterparts.
+
+// -----------------------------------------------------------------------------
+
+#ifndef __PGMSPACE_H_
+#define __PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P				const char *
+#define PSTR(s)				(s)
+
+#define pgm_read_byte(addr)	(*(const uint8_t *)(addr))
+#define pgm_read_word(addr)	(*(const uint16_t *)(addr))
+#define pgm_read_ptr(addr)	(*(void *const *)(addr))
+
+#define strcpy_P			strcpy
+#define strncpy_P			strncpy
+#define strlen_P			strlen
+#define strcmp_P			strcmp
+#define memcpy_P			memcpy
+
+#endif // __PGMSPACE_H_
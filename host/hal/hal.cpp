@@ -0,0 +1,696 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host HAL
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <Arduino.h>
+#include <FtModules.h>
+#include <util/twi.h>
+
+#include "pb_child.h"
+
+#include "hal.h"
+
+#pragma region Constants -------------------------------------------------------
+
+#define DISPLAY_ADDRESS			0x09
+#define DISPLAY_TEXT_LENGTH		6
+#define TWI_DATA_LENGTH			64
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Interrupt vectors -----------------------------------------------
+
+// Defined by the firmware with ISR(), if used
+
+void PCINT0_vect() __attribute__((weak));
+void PCINT1_vect() __attribute__((weak));
+void PCINT2_vect() __attribute__((weak));
+void INT0_vect() __attribute__((weak));
+void INT1_vect() __attribute__((weak));
+void TIMER0_COMPA_vect() __attribute__((weak));
+void ADC_vect() __attribute__((weak));
+void TWI_vect() __attribute__((weak));
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Variables -------------------------------------------------------
+
+HardwareSerial Serial;
+
+Hal::counters Hal::Counters;
+
+volatile uint8_t PCICR;
+volatile uint8_t PCIFR;
+volatile uint8_t PCMSK0;
+volatile uint8_t PCMSK1;
+volatile uint8_t PCMSK2;
+
+volatile uint8_t EICRA;
+volatile uint8_t EIMSK;
+volatile uint8_t EIFR;
+
+volatile uint8_t TIMSK0;
+volatile uint8_t TIFR0;
+volatile uint8_t OCR0A;
+
+volatile uint8_t ADMUX;
+volatile uint8_t ADCSRA;
+volatile uint8_t ADCSRB;
+volatile uint16_t ADC;
+
+volatile uint8_t TWBR;
+volatile uint8_t TWSR;
+volatile uint8_t TWDR;
+hostTwcr TWCR;
+
+static uint64_t nowUs = 0;
+static int pinValues[NUM_PINS];
+static bool interruptsOn = true;
+static bool inInterrupt = false;
+static uint64_t adcDoneUs = 0;
+static uint8_t adcPin;
+static uint8_t twcr;
+static uint64_t twiDoneUs = 0;
+static uint8_t twiStatus;
+static uint64_t sdaHoldUs = UINT64_MAX;
+static uint64_t sclStretchAtUs = UINT64_MAX;
+static uint64_t sclStretchUs;
+static bool twiOwned = false;
+static bool twiAddressed;
+static bool twiReading;
+static byte twiAddress;
+static byte twiData[TWI_DATA_LENGTH];
+static byte twiLength;
+static std::multimap<uint64_t, std::pair<byte, int>> events;
+
+static bool echoSerial = true;
+static bool echoI2C = false;
+
+static uint64_t serialCharUs = 174;
+static uint64_t serialIdleAt = 0;
+static std::string serialInput;
+
+static char displayText[DISPLAY_TEXT_LENGTH + 1];
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Virtual clock ---------------------------------------------------
+
+uint64_t Hal::Now()
+{
+	return nowUs;
+}
+
+static void setPin(byte pin, int value)
+{
+	bool changed = (pinValues[pin] != 0) != (value != 0);
+
+	pinValues[pin] = value;
+	if(!changed || pin >= A6) {
+		return;
+	}
+
+	// INT0/INT1: ISCn1 ISCn0 = 01 any change, 10 falling, 11 rising
+
+	if(pin == 2 || pin == 3) {
+		byte n = pin - 2;
+		byte sense = (EICRA >> (2 * n)) & 3;
+		if(sense == 1 || (sense == 2 && !value) || (sense == 3 && value)) {
+			EIFR |= bit(n);
+		}
+	}
+
+	if(pin < 8) {
+		if(PCMSK2 & bit(pin)) {
+			PCIFR |= bit(PCIF2);
+		}
+	} else if(pin < A0) {
+		if(PCMSK0 & bit(pin - 8)) {
+			PCIFR |= bit(PCIF0);
+		}
+	} else {
+		if(PCMSK1 & bit(pin - A0)) {
+			PCIFR |= bit(PCIF1);
+		}
+	}
+}
+
+static void runInterrupts()
+{
+	if(!interruptsOn || inInterrupt) {
+		return;
+	}
+
+	inInterrupt = true;
+	for(byte i = 0; i <= INTF1; i++) {
+		void (*vector)() = i == 0 ? INT0_vect : INT1_vect;
+		if((EIFR & bit(i)) && (EIMSK & bit(i))) {
+			EIFR &= ~bit(i);
+			if(vector) {
+				nowUs += ISR_OVERHEAD_US;
+				vector();
+			}
+		}
+	}
+	if((TIFR0 & bit(OCF0A)) && (TIMSK0 & bit(OCIE0A))) {
+		TIFR0 &= ~bit(OCF0A);
+		if(TIMER0_COMPA_vect) {
+			nowUs += ISR_OVERHEAD_US;
+			TIMER0_COMPA_vect();
+		}
+	}
+	for(byte i = 0; i <= PCIF2; i++) {
+		void (*vector)() = i == 0 ? PCINT0_vect : i == 1 ? PCINT1_vect : PCINT2_vect;
+		if((PCIFR & bit(i)) && (PCICR & bit(i))) {
+			PCIFR &= ~bit(i);
+			if(vector) {
+				nowUs += ISR_OVERHEAD_US;
+				vector();
+			}
+		}
+	}
+	if((ADCSRA & bit(ADIF)) && (ADCSRA & bit(ADIE))) {
+		ADCSRA &= ~bit(ADIF);
+		if(ADC_vect) {
+			nowUs += ISR_OVERHEAD_US;
+			ADC_vect();
+		}
+	}
+	if((twcr & bit(TWINT)) && (twcr & bit(TWIE))) {
+		if(TWI_vect) {
+			nowUs += ISR_OVERHEAD_US;
+			TWI_vect();
+		}
+	}
+	inInterrupt = false;
+}
+
+// Free-running conversions: the next one starts, with the multiplexer as it
+// is at that moment, as soon as one completes
+
+static uint64_t adcNextUs()
+{
+	const uint8_t running = bit(ADEN) | bit(ADSC) | bit(ADATE);
+
+	if((ADCSRA & running) != running) {
+		adcDoneUs = 0;
+		return UINT64_MAX;
+	}
+	if(!adcDoneUs) {
+		adcPin = A0 + (ADMUX & 0x0f);
+		adcDoneUs = nowUs + ADC_CONVERSION_US;
+	}
+	return adcDoneUs;
+}
+
+static void adcComplete()
+{
+	ADC = adcPin >= A6 ? pinValues[adcPin] : (pinValues[adcPin] ? 1023 : 0);
+	ADCSRA |= bit(ADIF);
+
+	adcPin = A0 + (ADMUX & 0x0f);
+	adcDoneUs = nowUs + ADC_CONVERSION_US;
+}
+
+// The TWI byte, start or stop in progress is done
+
+static void twiComplete()
+{
+	twcr |= bit(TWINT);
+	TWSR = twiStatus;
+	twiDoneUs = 0;
+}
+
+// Timer0 matches OCR0A once per overflow period
+
+static uint64_t timer0NextUs()
+{
+	return (nowUs / TIMER0_PERIOD_US + 1) * TIMER0_PERIOD_US;
+}
+
+// Inputs change, and interrupts run, at their own time within the step
+
+void Hal::Advance(uint64_t us)
+{
+	uint64_t target = nowUs + us;
+
+	for(;;) {
+		uint64_t eventUs = events.empty() ? UINT64_MAX : events.begin()->first;
+		uint64_t adcUs = adcNextUs();
+		uint64_t twiUs = twiDoneUs ? twiDoneUs : UINT64_MAX;
+		uint64_t timerUs = (TIMSK0 & bit(OCIE0A)) ? timer0NextUs() : UINT64_MAX;
+		uint64_t next = eventUs < adcUs ? eventUs : adcUs;
+
+		if(twiUs < next) {
+			next = twiUs;
+		}
+		if(timerUs < next) {
+			next = timerUs;
+		}
+
+		if(next > target) {
+			break;
+		}
+		if(next > nowUs) {
+			nowUs = next;
+		}
+
+		if(next == timerUs) {
+			TIFR0 |= bit(OCF0A);
+		} else if(next == twiUs) {
+			twiComplete();
+		} else if(eventUs <= adcUs) {
+			std::pair<byte, int> event = events.begin()->second;
+			events.erase(events.begin());
+			setPin(event.first, event.second);
+		} else {
+			adcComplete();
+		}
+		runInterrupts();
+	}
+
+	if(nowUs < target) {
+		nowUs = target;
+	}
+}
+
+void noInterrupts()
+{
+	interruptsOn = false;
+}
+
+void interrupts()
+{
+	interruptsOn = true;
+	runInterrupts();
+}
+
+unsigned long millis()
+{
+	Hal::Advance(CLOCK_READ_US);
+	return (unsigned long)(nowUs / 1000);
+}
+
+unsigned long micros()
+{
+	Hal::Advance(CLOCK_READ_US);
+	return (unsigned long)nowUs;
+}
+
+void delay(unsigned long ms)
+{
+	Hal::Advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	Hal::Advance(us);
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Pins ------------------------------------------------------------
+
+void Hal::SetPin(byte pin, int value)
+{
+	pinValues[pin] = value;
+}
+
+int Hal::PeekPin(byte pin)
+{
+	return pinValues[pin];
+}
+
+void Hal::HoldSda(uint64_t atMs)
+{
+	sdaHoldUs = atMs * 1000;
+}
+
+static bool sdaHeld()
+{
+	return nowUs >= sdaHoldUs;
+}
+
+void Hal::StretchScl(uint64_t atMs, uint64_t us)
+{
+	sclStretchAtUs = atMs * 1000;
+	sclStretchUs = us;
+}
+
+// A data byte to or from the child, stretched once a stretch is due
+
+static uint64_t twiByteUs()
+{
+	if(twiAddress != CHILD_ADDRESS || nowUs < sclStretchAtUs) {
+		return I2C_BYTE_US;
+	}
+	sclStretchAtUs = UINT64_MAX;
+	return I2C_BYTE_US + sclStretchUs;
+}
+
+void Hal::Schedule(uint64_t atMs, byte pin, int value)
+{
+	events.insert(std::make_pair(atMs * 1000, std::make_pair(pin, value)));
+}
+
+void Hal::Pulse(uint64_t atMs, byte pin, int value, uint64_t ms)
+{
+	Schedule(atMs + ms, pin, pinValues[pin]);
+	Schedule(atMs, pin, value);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+int digitalRead(uint8_t pin)
+{
+	Hal::Advance(DIGITAL_READ_US);
+	if(pin == SDA && sdaHeld()) {
+		return LOW;
+	}
+	return pinValues[pin] ? HIGH : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	Hal::Advance(DIGITAL_WRITE_US);
+	pinValues[pin] = val ? HIGH : LOW;
+
+	// Clocking SCL with the TWI off lets the device go
+
+	if(pin == SCL && !val && !(twcr & bit(TWEN)) && sdaHeld()) {
+		sdaHoldUs = UINT64_MAX;
+	}
+}
+
+int analogRead(uint8_t pin)
+{
+	Hal::Advance(ANALOG_READ_US);
+	return pin >= A6 ? pinValues[pin] : (pinValues[pin] ? 1023 : 0);
+}
+
+void analogWrite(uint8_t pin, int val)
+{
+	Hal::Advance(ANALOG_WRITE_US);
+	pinValues[pin] = val;
+}
+
+uint8_t hostPortInput(uint8_t firstPin)
+{
+	uint8_t value = 0;
+	uint8_t lastPin = firstPin == 8 ? 13 : firstPin + 7;
+
+	for(uint8_t pin = firstPin; pin <= lastPin && pin < A6; pin++) {
+		if(pinValues[pin]) {
+			value |= 1 << (pin - firstPin);
+		}
+	}
+	return value;
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Serial port -----------------------------------------------------
+
+void Hal::SerialInput(const char *str)
+{
+	serialInput += str;
+}
+
+void Hal::Echo(bool serial, bool i2c)
+{
+	echoSerial = serial;
+	echoI2C = i2c;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+	serialCharUs = 10000000UL / baud;
+}
+
+int HardwareSerial::available()
+{
+	return serialInput.size();
+}
+
+int HardwareSerial::read()
+{
+	if(serialInput.empty()) {
+		return -1;
+	}
+	int c = (byte)serialInput[0];
+	serialInput.erase(0, 1);
+	return c;
+}
+
+int HardwareSerial::availableForWrite()
+{
+	uint64_t pending = serialIdleAt > nowUs ? (serialIdleAt - nowUs + serialCharUs - 1) / serialCharUs : 0;
+
+	return pending < SERIAL_TX_BUFFER ? SERIAL_TX_BUFFER - pending : 0;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+	// Block like the real TX buffer does once it is full
+
+	if(serialIdleAt < nowUs) {
+		serialIdleAt = nowUs;
+	}
+	serialIdleAt += serialCharUs;
+	if(serialIdleAt > nowUs + SERIAL_TX_BUFFER * serialCharUs) {
+		uint64_t stall = serialIdleAt - nowUs - SERIAL_TX_BUFFER * serialCharUs;
+		Hal::Counters.serialStallUs += stall;
+		Hal::Advance(stall);
+	}
+
+	Hal::Counters.serialBytes++;
+	if(echoSerial) {
+		putchar(c);
+	}
+	return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+	while(n < size) {
+		n += write(buffer[n]);
+	}
+	return n;
+}
+
+size_t HardwareSerial::print(const char *str)
+{
+	size_t n = 0;
+	while(*str) {
+		n += write(*str++);
+	}
+	return n;
+}
+
+size_t HardwareSerial::print(const __FlashStringHelper *str)
+{
+	return print(reinterpret_cast<const char *>(str));
+}
+
+size_t HardwareSerial::print(char c)
+{
+	return write(c);
+}
+
+size_t HardwareSerial::print(int n, int base)
+{
+	return print((long)n, base);
+}
+
+size_t HardwareSerial::print(unsigned int n, int base)
+{
+	return printNumber(n, base);
+}
+
+size_t HardwareSerial::print(long n, int base)
+{
+	if(n < 0 && base == DEC) {
+		return write('-') + printNumber(-n, base);
+	}
+	return printNumber(n, base);
+}
+
+size_t HardwareSerial::print(unsigned long n, int base)
+{
+	return printNumber(n, base);
+}
+
+size_t HardwareSerial::println()
+{
+	return write('\r') + write('\n');
+}
+
+size_t HardwareSerial::println(const char *str)
+{
+	return print(str) + println();
+}
+
+size_t HardwareSerial::println(const __FlashStringHelper *str)
+{
+	return print(str) + println();
+}
+
+size_t HardwareSerial::println(char c)
+{
+	return print(c) + println();
+}
+
+size_t HardwareSerial::println(int n, int base)
+{
+	return print(n, base) + println();
+}
+
+size_t HardwareSerial::println(unsigned int n, int base)
+{
+	return print(n, base) + println();
+}
+
+size_t HardwareSerial::println(long n, int base)
+{
+	return print(n, base) + println();
+}
+
+size_t HardwareSerial::println(unsigned long n, int base)
+{
+	return print(n, base) + println();
+}
+
+size_t HardwareSerial::printNumber(unsigned long n, int base)
+{
+	char buf[8 * sizeof(long) + 1];
+	char *str = &buf[sizeof(buf) - 1];
+
+	*str = '\0';
+	do {
+		char c = n % base;
+		n /= base;
+		*--str = c < 10 ? c + '0' : c + 'A' - 10;
+	} while(n);
+
+	return print(str);
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region I²C -------------------------------------------------------------
+
+const char *Hal::DisplayText()
+{
+	return displayText;
+}
+
+// A whole transaction is known once it ends, with a stop or a repeated start
+
+static void twiEnd()
+{
+	if(!twiOwned) {
+		return;
+	}
+	twiOwned = false;
+
+	if(twiAddress == DISPLAY_ADDRESS && twiLength > 0) {
+		if(twiData[0] == FtModules::SevenSegDisplay::cmdDisplay) {
+			memset(displayText, 0, sizeof displayText);
+			memcpy(displayText, twiData + 1, twiLength - 1 < DISPLAY_TEXT_LENGTH ? twiLength - 1 : DISPLAY_TEXT_LENGTH);
+		} else if(twiData[0] == FtModules::SevenSegDisplay::cmdBlank) {
+			memset(displayText, 0, sizeof displayText);
+		}
+	}
+
+	if(echoI2C) {
+		printf("[%8.3f] I2C 0x%02x%s:", nowUs / 1000.0, twiAddress, twiReading ? " read" : "");
+		for(int i = 0; i < twiLength; i++) {
+			printf(" %02x", twiData[i]);
+		}
+		printf("\n");
+	}
+}
+
+static void twiStart(uint64_t us, uint8_t status)
+{
+	twiDoneUs = nowUs + us;
+	twiStatus = status;
+	Hal::Counters.i2cUs += us;
+}
+
+hostTwcr &hostTwcr::operator=(uint8_t value)
+{
+	// TWINT is cleared by writing a one to it, and only that starts anything
+
+	bool go = (value & bit(TWINT)) && (value & bit(TWEN));
+
+	twcr = go ? value & ~bit(TWINT) : (value & ~bit(TWINT)) | (twcr & bit(TWINT));
+	if(!go || twiDoneUs) {
+		return *this;
+	}
+
+	// With SDA held nothing ever completes
+
+	if(sdaHeld()) {
+		return *this;
+	}
+
+	if(value & bit(TWSTO)) {
+		twiEnd();
+		twcr &= ~bit(TWSTO);
+	} else if(value & bit(TWSTA)) {
+		uint8_t status = twiOwned ? TW_REP_START : TW_START;
+		twiEnd();
+		twiOwned = true;
+		twiAddressed = false;
+		twiLength = 0;
+		Hal::Counters.i2cTransactions++;
+		twiStart(I2C_START_STOP_US, status);
+	} else if(twiOwned) {
+		Hal::Counters.i2cBytes++;
+		if(!twiAddressed) {
+			twiAddressed = true;
+			twiAddress = TWDR >> 1;
+			twiReading = TWDR & TW_READ;
+			if(twiReading) {
+				twiStart(I2C_BYTE_US, twiAddress == CHILD_ADDRESS ? TW_MR_SLA_ACK : TW_MR_SLA_NACK);
+			} else {
+				twiStart(I2C_BYTE_US, twiAddress == DISPLAY_ADDRESS || twiAddress == CHILD_ADDRESS ?
+					TW_MT_SLA_ACK : TW_MT_SLA_NACK);
+			}
+		} else if(twiReading) {
+
+			// There is no child here: it reads as one whose queue never overflowed
+
+			TWDR = 0;
+			if(twiLength < sizeof twiData) {
+				twiData[twiLength++] = TWDR;
+			}
+			twiStart(twiByteUs(), value & bit(TWEA) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK);
+		} else {
+			if(twiLength < sizeof twiData) {
+				twiData[twiLength++] = TWDR;
+			}
+			twiStart(twiByteUs(), TW_MT_DATA_ACK);
+		}
+	}
+	return *this;
+}
+
+hostTwcr::operator uint8_t() const
+{
+	return twcr;
+}
+
+#pragma endregion --------------------------------------------------------------
@@ -0,0 +1,69 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host HAL control
+// Rubem Pechansky 2021
+
+// The host build runs on a virtual clock. Nothing ever sleeps: delay() moves
+// the clock forward, and every core call advances it by roughly what the same
+// call costs on a 16 MHz ATmega328P, so loop timings stay meaningful.
+
+// -----------------------------------------------------------------------------
+
+#ifndef hal_h
+#define hal_h
+
+#include <Arduino.h>
+
+// Approximate costs on the target, in µs
+
+#define DIGITAL_READ_US			4
+#define DIGITAL_WRITE_US		4
+#define ANALOG_READ_US			112
+#define ANALOG_WRITE_US			6
+#define CLOCK_READ_US			1
+#define ISR_OVERHEAD_US			3
+#define ADC_CONVERSION_US		104		// 13 ADC clocks @ 125 kHz
+#define TIMER0_PERIOD_US		1024	// 256 ticks @ 250 kHz
+#define I2C_START_STOP_US		20
+#define I2C_BYTE_US				90		// 9 bits @ 100 kHz
+#define SERIAL_TX_BUFFER		64
+
+namespace Hal
+{
+	struct counters {
+		unsigned long i2cTransactions;
+		unsigned long i2cBytes;
+		unsigned long serialBytes;
+		uint64_t i2cUs;
+		uint64_t serialStallUs;
+	};
+
+	extern counters Counters;
+
+	// Virtual clock
+
+	uint64_t Now();
+	void Advance(uint64_t us);
+
+	// Inputs. Analog-only pins (A6, A7) take 0-1023, all others HIGH/LOW
+
+	void SetPin(byte pin, int value);
+	int PeekPin(byte pin);
+	void Schedule(uint64_t atMs, byte pin, int value);
+	void Pulse(uint64_t atMs, byte pin, int value, uint64_t ms);
+	void SerialInput(const char *str);
+
+	// Faults. From atMs a device holds SDA low until SCL is clocked by hand.
+	// StretchScl() has the child hold SCL for us more on its next byte after
+	// atMs, as it does while its interrupts are off.
+
+	void HoldSda(uint64_t atMs);
+	void StretchScl(uint64_t atMs, uint64_t us);
+
+	// Output
+
+	void Echo(bool serial, bool i2c);
+	const char *DisplayText();
+}
+
+#endif // hal_h
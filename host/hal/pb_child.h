@@ -0,0 +1,88 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host stand-in for pb_child.h (ft-modules-lib)
+// Rubem Pechansky 2021
+
+// Primary/child protocol. Keep in sync with the library copy.
+
+// -----------------------------------------------------------------------------
+
+#ifndef pb_child_h
+#define pb_child_h
+
+#define CHILD_ADDRESS		0x08
+#define NLEDS				9
+#define SERVO_TIMER			500
+
+// Each transaction to the child is a packet of one or more commands, each
+// preceded by its length in bytes
+
+#define CHILD_PACKET_LENGTH	32
+
+// Child commands
+
+enum class childCommands
+{
+	RESET = 1,
+	PORT,
+	SERVO,
+	SOUND,
+	LED,
+	MOTOR,
+	LED_FRAME,
+	LED_FADE,				// LED, level 0-255, time (1/10 s)
+};
+
+// LED_FRAME carries a state and a time (1/10 s) for each of the NLEDS LEDs.
+// LEDs whose state is LED_KEEP are left as they are.
+
+#define LED_FRAME_LENGTH	(1 + 2 * NLEDS)
+#define LED_KEEP			0xff
+
+enum class servoCmd
+{
+	CLOSE = 0,
+	OPEN,
+};
+
+enum class outState
+{
+	OFF = 0,
+	ON,
+	FLASH,
+	ONESHOT,
+};
+
+// Child LEDs, in the same order as ledData[] in child.ino
+
+enum class childLeds
+{
+	ROLLOVER1 = 0,
+	ROLLOVER2,
+	ROLLOVER3,
+	ROLLOVER_SKILL,
+	HOLD,
+	RIGHT_OUTLANE,
+	LEFT_OUTLANE,
+	LEFT_ORBIT,
+	LIGHTS,
+};
+
+// DFPlayer track numbers
+
+enum soundNames
+{
+	DING = 1,
+	DRAIN,
+	GLASS,
+	CLANG,
+	FAUCET,
+	CRASH,
+	FRYING,
+	BUBBLES,
+	CABINET,
+	SHAKE,
+	BELL,
+};
+
+#endif // pb_child_h
@@ -0,0 +1,289 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Host simulator
+// Rubem Pechansky 2021
+
+// Plays one scripted game against the primary firmware on the virtual clock
+// and reports the final score and loop timing.
+
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "hal.h"
+#include "pinball.h"
+#include "general.h"
+#include "messages.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "tests.h"
+
+#pragma region Constants -------------------------------------------------------
+
+#define GAME_START_PRESS_MS		500
+#define LAUNCH_DELAY_MS			400
+#define SCL_STRETCH_US			1100	// The child sending one byte to the DFPlayer
+#define SIM_TIMEOUT_MS			600000UL
+
+// Sensor levels while idle and while hit
+
+#define ANALOG_IDLE				900
+#define ANALOG_HIT				300
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Scenario --------------------------------------------------------
+
+struct simStep {
+	uint ms;				// After entering PLAYING
+	byte pin;
+	int value;
+	uint duration;			// 0 = stay until the ball is lost
+};
+
+const simStep ballScript[] = {
+	{200, rollover1Sensor, LOW, 30},
+	{500, rollover2Sensor, LOW, 30},
+	{800, rollover3Sensor, LOW, 30},
+	{1000, leftButton, LOW, 300},
+	{1100, spinnerSensor, LOW, 8},			// Spinning down
+	{1130, spinnerSensor, LOW, 8},
+	{1165, spinnerSensor, LOW, 8},
+	{1205, spinnerSensor, LOW, 8},
+	{1255, spinnerSensor, LOW, 8},
+	{1325, spinnerSensor, LOW, 8},
+	{1425, spinnerSensor, LOW, 8},
+	{1575, spinnerSensor, LOW, 8},
+	{1770, spinnerSensor, LOW, 8},
+	{2000, leftOrbitSensor, HIGH, 30},
+	{2500, holdSensor, ANALOG_HIT, 80},
+	{3000, holdSensor, ANALOG_HIT, 80},
+	{3500, holdSensor, ANALOG_HIT, 80},
+	{4000, rightButton, LOW, 200},
+	{4200, rolloverSkillSensor, LOW, 30},
+};
+
+// One entry per launch: when and how the ball drains
+
+struct simDrain {
+	uint ms;
+	bool outlane;
+};
+
+const simDrain drains[] = {
+	{5000, false},
+	{1500, false},			// Within BALL_SAVER_TIME: saved
+	{5000, false},
+	{4500, true},
+};
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Firmware ---------------------------------------------------------
+
+extern gameStates gameState;
+extern bcd playerScore;
+extern Messages Msg;
+
+void setup();
+void loop();
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Simulator -------------------------------------------------------
+
+uint launches = 0;
+
+ulong fromBcd(bcd value)
+{
+	ulong n = 0;
+	for(int shift = 28; shift >= 0; shift -= 4) {
+		n = n * 10 + ((value >> shift) & 0x0f);
+	}
+	return n;
+}
+
+void setIdleLevels()
+{
+	Hal::SetPin(leftButton, HIGH);
+	Hal::SetPin(rightButton, HIGH);
+	Hal::SetPin(leftOutlaneSensor, HIGH);
+	Hal::SetPin(rightOutlaneSensor, HIGH);
+	Hal::SetPin(rolloverSkillSensor, HIGH);
+	Hal::SetPin(rollover1Sensor, HIGH);
+	Hal::SetPin(rollover2Sensor, HIGH);
+	Hal::SetPin(rollover3Sensor, HIGH);
+	Hal::SetPin(ballLostSensor, LOW);
+	Hal::SetPin(feederHomeSensor, LOW);
+	Hal::SetPin(ballNearHomeSensor, HIGH);
+	Hal::SetPin(spinnerSensor, HIGH);
+	Hal::SetPin(leftOrbitSensor, LOW);
+	Hal::SetPin(holdSensor, ANALOG_IDLE);
+	Hal::SetPin(launchSensor, ANALOG_IDLE);
+}
+
+void enterState(gameStates state)
+{
+	uint64_t ms = Hal::Now() / 1000;
+
+	switch(state) {
+
+		case gameStates::LAUNCHING:
+			Hal::Pulse(ms + LAUNCH_DELAY_MS, launchSensor, ANALOG_HIT, 50);
+			break;
+
+		case gameStates::PLAYING: {
+			const simDrain &drain = drains[launches++ % NUMITEMS(drains)];
+
+			for(uint i = 0; i < NUMITEMS(ballScript); i++) {
+				const simStep &step = ballScript[i];
+				if(step.ms < drain.ms) {
+					Hal::Pulse(ms + step.ms, step.pin, step.value, step.duration);
+				}
+			}
+			if(drain.outlane) {
+				Hal::Pulse(ms + drain.ms, leftOutlaneSensor, LOW, 30);
+			}
+			Hal::Schedule(ms + drain.ms + 300, ballLostSensor, HIGH);
+			break;
+		}
+
+		case gameStates::BALL_LOST:
+			Hal::SetPin(ballLostSensor, LOW);
+
+			// The spinner is still coasting: these vanes must not count on the
+			// next ball
+
+			Hal::Pulse(ms + 100, spinnerSensor, LOW, 8);
+			Hal::Pulse(ms + 250, spinnerSensor, LOW, 8);
+			break;
+
+		default:
+			break;
+	}
+}
+
+void usage()
+{
+	printf("Usage: pinball-host [-q] [-v] [--hold-sda ms] [--stretch-scl ms] [--profile] [--expect score]\n");
+	printf("  -q             Don't echo the serial port\n");
+	printf("  -v             Echo I2C traffic\n");
+	printf("  --hold-sda     Have a device hold SDA low at that time\n");
+	printf("  --stretch-scl  Have the child stretch SCL once at that time; fail if the\n");
+	printf("                 bus is cleared\n");
+	printf("  --profile      Dump the zone profile after the game (build with PROFILER=1)\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	bool quiet = false;
+	bool verbose = false;
+	bool profile = false;
+	long expected = -1;
+	bool stretch = false;
+
+	for(int i = 1; i < argc; i++) {
+		if(!strcmp(argv[i], "-q")) {
+			quiet = true;
+		} else if(!strcmp(argv[i], "-v")) {
+			verbose = true;
+		} else if(!strcmp(argv[i], "--hold-sda") && i + 1 < argc) {
+			Hal::HoldSda(atol(argv[++i]));
+		} else if(!strcmp(argv[i], "--stretch-scl") && i + 1 < argc) {
+			Hal::StretchScl(atol(argv[++i]), SCL_STRETCH_US);
+			stretch = true;
+		} else if(!strcmp(argv[i], "--profile")) {
+			profile = true;
+		} else if(!strcmp(argv[i], "--expect") && i + 1 < argc) {
+			expected = atol(argv[++i]);
+		} else {
+			usage();
+		}
+	}
+
+	Hal::Echo(!quiet, verbose);
+	setIdleLevels();
+
+	auto wallStart = std::chrono::steady_clock::now();
+
+	setup();
+	Hal::Pulse(Hal::Now() / 1000 + GAME_START_PRESS_MS, rightButton, LOW, 100);
+
+	ulong passes = 0;
+	uint64_t worstUs = 0;
+	gameStates worstState = gameState;
+	bool gameOver = false;
+
+	while(Hal::Now() / 1000 < SIM_TIMEOUT_MS) {
+		gameStates state = gameState;
+		uint64_t start = Hal::Now();
+
+		loop();
+
+		uint64_t us = Hal::Now() - start;
+		passes++;
+		if(us > worstUs) {
+			worstUs = us;
+			worstState = state;
+		}
+
+		if(gameState != state) {
+			if(gameState == gameStates::GAME_OVER) {
+				gameOver = true;
+			}
+			enterState(gameState);
+		}
+
+		// Done once back at the start and the last messages are shown
+
+		if(gameOver && gameState == gameStates::GAME_START && !Msg.Busy()) {
+			break;
+		}
+	}
+
+	// The 'p' command dumps the ring as it stands: the last zones of the game
+
+	if(profile) {
+		Hal::Echo(true, verbose);
+		Hal::SerialInput("p");
+		loop();
+	}
+
+	double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+	printf("\n");
+	printf("Final score:   %lu\n", fromBcd(playerScore));
+	printf("Virtual time:  %.1f s (%.1f ms wall)\n", Hal::Now() / 1e6, wallMs);
+	printf("Loop passes:   %lu, worst %llu us in %s\n", passes,
+		(unsigned long long)worstUs, (const char *)Tests::StateName(worstState));
+	printf("I2C:           %lu transactions, %lu bytes, %.1f ms on the bus\n",
+		Hal::Counters.i2cTransactions, Hal::Counters.i2cBytes, Hal::Counters.i2cUs / 1000.0);
+	printf("I2C queue:     %u left, %u dropped\n", Twi::Depth(), Twi::Dropped());
+	printf("I2C errors:    child %u, display %u, bus cleared %u times\n",
+		Twi::Errors(CHILD_ADDRESS), Twi::Errors(SEVENSEGDISPLAY_ADR), Twi::Recoveries());
+	printf("Child cmds:    %lu sent, %lu suppressed\n", childCmdsSent, childCmdsSuppressed);
+	printf("Serial:        %lu bytes, %.1f ms stalled\n",
+		Hal::Counters.serialBytes, Hal::Counters.serialStallUs / 1000.0);
+	printf("Telemetry:     %lu frames, %lu dropped\n", Telemetry::Sent(), Telemetry::Dropped());
+	printf("Messages:      %u dropped\n", Msg.Dropped());
+
+	if(!gameOver) {
+		printf("FAIL: game did not finish\n");
+		return 1;
+	}
+	if(stretch && Twi::Recoveries()) {
+		printf("FAIL: bus cleared while the child stretched SCL\n");
+		return 1;
+	}
+	if(expected >= 0 && (ulong)expected != fromBcd(playerScore)) {
+		printf("FAIL: expected score %ld\n", expected);
+		return 1;
+	}
+	return 0;
+}
+
+#pragma endregion --------------------------------------------------------------
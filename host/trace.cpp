@@ -0,0 +1,85 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Profile dump to Chrome trace converter
+// Rubem Pechansky 2021
+
+// Reads serial output containing a 'p' dump (see pinball/profiler.h) and writes
+// Chrome trace JSON, to be opened in chrome://tracing or ui.perfetto.dev.
+
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PROFILE_HEADER			"----- Profile (us) -----"
+#define MAX_THREADS				2
+
+int main(int argc, char *argv[])
+{
+	char line[256];
+	bool found = false;
+
+	if(argc > 1) {
+		fprintf(stderr, "Usage: pinball-trace < serial.log > trace.json\n");
+		return 2;
+	}
+
+	while(fgets(line, sizeof line, stdin)) {
+		if(!strncmp(line, PROFILE_HEADER, strlen(PROFILE_HEADER))) {
+			found = true;
+			break;
+		}
+	}
+	if(!found) {
+		fprintf(stderr, "pinball-trace: no profile dump in the input\n");
+		return 1;
+	}
+
+	// micros() wraps every 71 minutes; the ring may also start inside a zone,
+	// so unmatched ends are dropped
+
+	uint64_t base = 0;
+	unsigned long lastUs = 0;
+	int depth[MAX_THREADS + 1] = {0};
+	int events = 0;
+	bool started = false;
+
+	printf("{\"traceEvents\":[\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"loop\"}},\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"interrupts\"}}");
+
+	while(fgets(line, sizeof line, stdin)) {
+		unsigned long us;
+		char ph;
+		int tid;
+		char name[64];
+
+		if(sscanf(line, "%lu %c %d %63s", &us, &ph, &tid, name) != 4 ||
+			(ph != 'B' && ph != 'E') || tid < 1 || tid > MAX_THREADS) {
+			break;
+		}
+
+		if(started && us < lastUs && lastUs - us > 0x80000000UL) {
+			base += 0x100000000ULL;
+		}
+		lastUs = us;
+		started = true;
+
+		if(ph == 'B') {
+			depth[tid]++;
+		} else if(depth[tid]) {
+			depth[tid]--;
+		} else {
+			continue;
+		}
+
+		printf(",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%llu}",
+			name, ph, tid, (unsigned long long)(base + us));
+		events++;
+	}
+
+	printf("\n]}\n");
+	fprintf(stderr, "pinball-trace: %d events\n", events);
+	return 0;
+}
@@ -0,0 +1,75 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Interrupt-driven analog sensors
+// Rubem Pechansky 2021
+
+// The ADC runs free, alternating between holdSensor (A6) and launchSensor (A7),
+// and the interrupt handler keeps the latest value of each. Reading one costs
+// nothing instead of the ~110 µs an analogRead() blocks for.
+
+// Only A6 and A7 are sampled; analogRead() must not be used while this runs.
+
+// -----------------------------------------------------------------------------
+
+#include "adc.h"
+
+#pragma region Hardware constants ----------------------------------------------
+
+#define ADC_FIRST_PIN			A6
+#define ADC_CHANNELS			2
+#define ADC_PRESCALER			(bit(ADPS2) | bit(ADPS1) | bit(ADPS0))		// 125 kHz
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Variables -------------------------------------------------------
+
+volatile int adcValues[ADC_CHANNELS];
+volatile byte adcConverting = 0;		// Channel of the conversion in progress
+volatile byte adcNext = 0;				// Channel the multiplexer is set to
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Interrupt handler -----------------------------------------------
+
+// In free-running mode the next conversion has already started, with the old
+// multiplexer setting, when this runs; the new setting applies to the one after
+
+ISR(ADC_vect)
+{
+	int value = ADC;
+	volatile int *slot = &adcValues[adcConverting];
+
+	*slot += (value - *slot) >> ADC_AVERAGE_SHIFT;
+
+	adcConverting = adcNext;
+	adcNext = adcNext == ADC_CHANNELS - 1 ? 0 : adcNext + 1;
+	ADMUX = bit(REFS0) | (ADC_FIRST_PIN - A0 + adcNext);
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Methods ---------------------------------------------------------
+
+void Adc::Init()
+{
+	for(byte i = 0; i < ADC_CHANNELS; i++) {
+		adcValues[i] = 1023;
+	}
+
+	ADMUX = bit(REFS0) | (ADC_FIRST_PIN - A0);
+	ADCSRB = 0;
+	ADCSRA = bit(ADEN) | bit(ADSC) | bit(ADATE) | bit(ADIE) | ADC_PRESCALER;
+}
+
+int Adc::Read(byte pin)
+{
+	int value;
+
+	noInterrupts();
+	value = adcValues[pin - ADC_FIRST_PIN];
+	interrupts();
+
+	return value;
+}
+
+#pragma endregion --------------------------------------------------------------
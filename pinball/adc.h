@@ -0,0 +1,22 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Interrupt-driven analog sensors
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#ifndef adc_h
+#define adc_h
+
+#include "pinball.h"
+
+#define ADC_AVERAGE_SHIFT		1		// Running average over 2^n samples
+
+class Adc
+{
+  public:
+	static void Init();
+	static int Read(byte pin);
+};
+
+#endif // adc_h
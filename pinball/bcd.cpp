@@ -0,0 +1,41 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Packed BCD scores
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#include "bcd.h"
+
+#pragma region Public methods --------------------------------------------------
+
+// Biases every digit by 6 so that a decimal carry is also a binary one, adds,
+// then takes the 6 back from the digits that did not carry
+
+bcd Bcd::Add(bcd a, bcd b)
+{
+	bcd t1 = a + 0x06666666;
+	bcd t2 = t1 + b;
+	bcd noCarry = ~(t2 ^ t1 ^ b) & 0x11111110;
+
+	return t2 - ((noCarry >> 2) | (noCarry >> 3));
+}
+
+// Shift and add; n is a small constant such as the multiplier
+
+bcd Bcd::Mul(bcd a, byte n)
+{
+	bcd result = 0;
+
+	while(n) {
+		if(n & 1) {
+			result = Add(result, a);
+		}
+		a = Add(a, a);
+		n >>= 1;
+	}
+
+	return result;
+}
+
+#pragma endregion --------------------------------------------------------------
@@ -0,0 +1,26 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Packed BCD scores
+// Rubem Pechansky 2021
+
+// Scores hold one decimal digit per nibble, so 0x1250 is 1250 points. The
+// AVR has no divider; this way adding and showing a score never divides.
+// Seven digits are kept; the top nibble only collects the overflow.
+
+// -----------------------------------------------------------------------------
+
+#ifndef bcd_h
+#define bcd_h
+
+#include <Arduino.h>
+
+typedef uint32_t bcd;
+
+class Bcd
+{
+  public:
+	static bcd Add(bcd a, bcd b);
+	static bcd Mul(bcd a, byte n);
+};
+
+#endif // bcd_h
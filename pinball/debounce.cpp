@@ -8,79 +8,131 @@
 // -----------------------------------------------------------------------------
 
 #include "debounce.h"
+#include "adc.h"
 
 #pragma region Hardware constants ----------------------------------------------
 
+#define MAX_SENSORS				8
+
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Hardware variables ----------------------------------------------
 
-uint sensorState[ARDUINO_PINS];
-uint lastSensorState[ARDUINO_PINS];
-ulong lastDebounceTime[ARDUINO_PINS];
+// One bit per pin (see PIN_MASK) for reported and last readings; timestamps
+// and policies only for registered sensors
+
+ulong sensorState;
+ulong lastReadings;
+
+sSensor sensors[MAX_SENSORS];
+byte nSensors = 0;
 
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Sensor functions ------------------------------------------------
 
-void Debounce::Read(byte pin, void (*changeStateCallback)() = NULL,
-	bool invert = true)
+void Debounce::Register(byte pin, debouncePolicy policy,
+	byte window = DEFAULT_DEBOUNCE)
 {
-	int reading = digitalRead(pin);
-	if(invert) {
-		reading = !reading;
-	}
+	sSensor *sensor = find(pin);
 
-	if(reading != sensorState[pin]) {
-		sensorState[pin] = reading;
-		if(reading && changeStateCallback) {
-			changeStateCallback();
+	if(!sensor) {
+		if(nSensors == MAX_SENSORS) {
+			return;
 		}
+		sensor = &sensors[nSensors++];
+		sensor->pin = pin;
 	}
+
+	sensor->policy = policy;
+	sensor->window = window;
+	sensor->changedMs = millis();
+}
+
+// Digital sensors come from the port snapshot taken by Inputs::Read()
+
+void Debounce::Read(byte pin, void (*changeStateCallback)() = NULL,
+	bool invert = true)
+{
+	report(pin, PIN_HIGH(pin) != invert, changeStateCallback);
 }
 
 void Debounce::Digital(byte pin, void (*changeStateCallback)() = NULL,
-	bool invert = true, ulong debounceDelay = DEFAULT_DEBOUNCE)
+	bool invert = true)
 {
-	int reading = digitalRead(pin);
-	if(invert) {
-		reading = !reading;
+	sSensor *sensor = find(pin);
+
+	if(!sensor || sensor->policy == debouncePolicy::INTEGRATOR) {
+		report(pin, PIN_STABLE(pin) != invert, changeStateCallback);
+	} else {
+		filter(sensor, PIN_HIGH(pin) != invert, changeStateCallback);
 	}
+}
+
+// Unregistered analog sensors register as trailing edge on the first call
 
-	if(reading != lastSensorState[pin]) {
-		lastDebounceTime[pin] = millis();
+void Debounce::Analog(byte pin, int min, int max, void (*changeStateCallback)() = NULL,
+	bool invert = true, ulong debounceDelay = ANALOG_DEBOUNCE)
+{
+	int val = Adc::Read(pin);
+	bool reading = val >= min && val < max;
+	sSensor *sensor = find(pin);
+
+	if(!sensor) {
+		Register(pin, debouncePolicy::TRAILING_EDGE, debounceDelay);
+		sensor = find(pin);
+	}
+
+	if(sensor) {
+		filter(sensor, reading, changeStateCallback);
+	} else {
+		report(pin, reading, changeStateCallback);
 	}
+}
+
+#pragma endregion --------------------------------------------------------------
 
-	if((millis() - lastDebounceTime[pin]) > debounceDelay) {
-		if(reading != sensorState[pin]) {
-			sensorState[pin] = reading;
-			if(reading && changeStateCallback) {
-				changeStateCallback();
-			}
+#pragma region Private methods -------------------------------------------------
+
+sSensor *Debounce::find(byte pin)
+{
+	for(byte i = 0; i < nSensors; i++) {
+		if(sensors[i].pin == pin) {
+			return &sensors[i];
 		}
 	}
-	lastSensorState[pin] = reading;
+	return NULL;
 }
 
-void Debounce::Analog(byte pin, int min, int max, void (*changeStateCallback)() = NULL,
-	bool invert = true, ulong debounceDelay = ANALOG_DEBOUNCE)
+void Debounce::filter(sSensor *sensor, bool reading, void (*changeStateCallback)())
 {
-	int val = analogRead(pin);
-	bool reading = val >= min && val < max;
+	ulong mask = PIN_MASK(sensor->pin);
+	uint elapsed = (uint)millis() - sensor->changedMs;
+
+	if(sensor->policy == debouncePolicy::LEADING_EDGE) {
+		if(elapsed >= sensor->window && reading != ((sensorState & mask) != 0)) {
+			sensor->changedMs = millis();
+			report(sensor->pin, reading, changeStateCallback);
+		}
+		return;
+	}
 
-	if(reading != lastSensorState[pin]) {
-		lastDebounceTime[pin] = millis();
+	if(reading != ((lastReadings & mask) != 0)) {
+		lastReadings ^= mask;
+		sensor->changedMs = millis();
+	} else if(elapsed > sensor->window) {
+		report(sensor->pin, reading, changeStateCallback);
 	}
+}
 
-	if((millis() - lastDebounceTime[pin]) > debounceDelay) {
-		if(reading != sensorState[pin]) {
-			sensorState[pin] = reading;
-			if(reading && changeStateCallback) {
-				changeStateCallback();
-			}
+void Debounce::report(byte pin, bool reading, void (*changeStateCallback)())
+{
+	if(reading != ((sensorState & PIN_MASK(pin)) != 0)) {
+		sensorState ^= PIN_MASK(pin);
+		if(reading && changeStateCallback) {
+			changeStateCallback();
 		}
 	}
-	lastSensorState[pin] = reading;
 }
 
 #pragma endregion --------------------------------------------------------------
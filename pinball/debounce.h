@@ -14,19 +14,43 @@
 
 #define DEFAULT_DEBOUNCE		5
 #define ANALOG_DEBOUNCE			50
+#define ROLLOVER_LOCKOUT		10
+
+// Debounce policies
+
+enum class debouncePolicy : byte
+{
+	INTEGRATOR = 0,			// Digital only: vertical counter in Inputs
+	TRAILING_EDGE,			// Fire once the input has been stable for window ms
+	LEADING_EDGE,			// Fire at once, then ignore the input for window ms
+};
+
+struct sSensor {
+	byte pin;
+	debouncePolicy policy;
+	byte window;			// ms
+	uint changedMs;			// Low 16 bits of millis() on AVR
+};
 
 class Debounce
 {
   public:
+	static void Register(byte pin, debouncePolicy policy,
+		byte window = DEFAULT_DEBOUNCE);
 	static void Read(byte pin,
 		void (*changeStateCallback)() = NULL,
 		bool invert = true);
 	static void Digital(byte pin,
 		void (*changeStateCallback)() = NULL,
-		bool invert = true, ulong debounceDelay = DEFAULT_DEBOUNCE);
+		bool invert = true);
 	static void Analog(byte pin, int min, int max,
 		void (*changeStateCallback)() = NULL,
 		bool invert = true, ulong debounceDelay = ANALOG_DEBOUNCE);
+
+  private:
+	static sSensor *find(byte pin);
+	static void filter(sSensor *sensor, bool reading, void (*changeStateCallback)());
+	static void report(byte pin, bool reading, void (*changeStateCallback)());
 };
 
 #endif // debounce_h
@@ -10,6 +10,18 @@
 #pragma region Constants -------------------------------------------------------
 
 #define DISPLAY_INIT_TIME		200
+#define DISPLAY_FRAME_TIME		20		// Minimum time between updates, ms
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Variables -------------------------------------------------------
+
+// Commands only change the wanted state; Update() sends it to the module at
+// most once per frame, and only when it differs from what is shown
+
+displayState wanted = {"", displayModes::BLANK, 0};
+displayState shown = {"", displayModes::UNKNOWN, 0};
+AsyncDelay frameTimer;
 
 #pragma endregion --------------------------------------------------------------
 
@@ -17,44 +29,101 @@
 
 void Display::Init()
 {
-	Display::Clear();
+	Twi::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdBlank);
 	Display::Test();
 	delay(DISPLAY_INIT_TIME);
 }
 
 void Display::Clear()
 {
-	FtModules::I2C::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdBlank);
+	wanted.text[0] = '\0';
+	wanted.mode = displayModes::BLANK;
 }
 
+// Sent right away; what is shown afterwards is unknown
+
 void Display::Test()
 {
-	FtModules::I2C::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdTest);
+	Twi::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdTest);
+	shown.mode = displayModes::UNKNOWN;
 }
 
 void Display::Show(char *str)
 {
-	FtModules::I2C::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdDisplay, str);
+	strncpy(wanted.text, str, DISPLAY_TEXT_LENGTH);
+	wanted.text[DISPLAY_TEXT_LENGTH] = '\0';
+	if(wanted.mode == displayModes::BLANK) {
+		wanted.mode = displayModes::SHOW;
+	}
+}
+
+// Copies straight from flash
+
+void Display::Show(const __FlashStringHelper *str)
+{
+	strncpy_P(wanted.text, (PGM_P)str, DISPLAY_TEXT_LENGTH);
+	wanted.text[DISPLAY_TEXT_LENGTH] = '\0';
+	if(wanted.mode == displayModes::BLANK) {
+		wanted.mode = displayModes::SHOW;
+	}
 }
 
 // void Display::Hold(uint ms)
 // {
-// 	FtModules::I2C::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdHold, lowByte(ms), highByte(ms));
+// 	Twi::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdHold, lowByte(ms), highByte(ms));
 // }
 
 void Display::Flash(uint ms)
 {
-	FtModules::I2C::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdFlash, lowByte(ms), highByte(ms));
+	wanted.mode = displayModes::FLASH;
+	wanted.time = ms;
 }
 
 void Display::Rotate(uint ms)
 {
-	FtModules::I2C::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdRotate, ms);
+	wanted.mode = displayModes::ROTATE;
+	wanted.time = ms;
 }
 
 void Display::Stop()
 {
-	FtModules::I2C::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdStop);
+	if(wanted.mode != displayModes::BLANK) {
+		wanted.mode = displayModes::SHOW;
+	}
+}
+
+void Display::Update()
+{
+	if(!frameTimer.isExpired()) {
+		return;
+	}
+
+	bool effect = wanted.mode == displayModes::FLASH || wanted.mode == displayModes::ROTATE;
+
+	if(wanted.mode == shown.mode && !strcmp(wanted.text, shown.text) &&
+	   (!effect || wanted.time == shown.time)) {
+		return;
+	}
+
+	if(wanted.mode == displayModes::BLANK || wanted.mode == displayModes::ROTATE) {
+		Twi::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdBlank);
+	}
+	if(shown.mode != displayModes::SHOW && shown.mode != displayModes::BLANK) {
+		Twi::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdStop);
+	}
+	if(wanted.mode != displayModes::BLANK) {
+		Twi::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdDisplay, wanted.text);
+	}
+
+	if(wanted.mode == displayModes::FLASH) {
+		Twi::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdFlash,
+			lowByte(wanted.time), highByte(wanted.time));
+	} else if(wanted.mode == displayModes::ROTATE) {
+		Twi::Cmd(SEVENSEGDISPLAY_ADR, FtModules::SevenSegDisplay::cmdRotate, wanted.time);
+	}
+
+	shown = wanted;
+	frameTimer.start(DISPLAY_FRAME_TIME, AsyncDelay::MILLIS);
 }
 
 void Display::U2s(char *buffer, unsigned long value)
@@ -67,4 +136,14 @@ void Display::U2s(char *buffer, unsigned long value)
 	}
 }
 
+// Right-justified like U2s(), one digit per nibble and no arithmetic
+
+void Display::Bcd2s(char *buffer, bcd value)
+{
+	for(int i = DISPLAYCHARS - 1; i >= 0; i--) {
+		buffer[i] = (value == 0 && i != DISPLAYCHARS - 1) ? ' ' : '0' + (value & 0x0f);
+		value >>= 4;
+	}
+}
+
 #pragma endregion --------------------------------------------------------------
@@ -9,14 +9,36 @@
 #define display_h
 
 #include <Arduino.h>
+#include <AsyncDelay.h>
 #include <FtModules.h>
 #include "Simpletypes.h"
+#include "bcd.h"
+#include "twi.h"
 
 // Constants for other modules
 
 #define SEVENSEGDISPLAY_ADR		0x09
 #define DISPLAYCHARS			6
 
+// Longest text a single I²C command can carry
+
+#define DISPLAY_TEXT_LENGTH		(TWI_CMD_LENGTH - 1)
+
+enum class displayModes : byte
+{
+	UNKNOWN = 0,
+	BLANK,
+	SHOW,
+	FLASH,
+	ROTATE,
+};
+
+struct displayState {
+	char text[DISPLAY_TEXT_LENGTH + 1];
+	displayModes mode;
+	uint time;
+};
+
 class Display
 {
   public:
@@ -24,11 +46,14 @@ class Display
 	static void Clear();
 	static void Test();
 	static void Show(char *str);
+	static void Show(const __FlashStringHelper *str);
 	static void Hold(uint ms);
 	static void Flash(uint ms);
 	static void Rotate(uint ms);
 	static void Stop();
+	static void Update();
 	static void U2s(char *buffer, unsigned long value);
+	static void Bcd2s(char *buffer, bcd value);
 };
 
 
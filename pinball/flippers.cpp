@@ -6,6 +6,7 @@
 // -----------------------------------------------------------------------------
 
 #include "flippers.h"
+#include "profiler.h"
 
 #pragma region Hardware constants ----------------------------------------------
 
@@ -14,95 +15,173 @@
 #define MAX_POWER_MS			50
 #define HOLD_PWM				40
 
+// Timer0 compare A interrupts once per 1024 µs
+
+#define TICK_US					1024
+#define STROKE_TICKS			((MAX_POWER_MS * 1000L + TICK_US / 2) / TICK_US)
+#define BOUNCE_TICKS			5		// A stroke is not cut short before this
+#define RELEASE_TICKS			5		// Button up this long before it can fire again
+#define HELD_TICKS				2		// Button down this long to fire from the tick
+
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Enums -----------------------------------------------------------
 
 // Flipper states
 
-enum class flipperStates
+enum class flipperStates : byte
 {
 	IDLE = 0,
 	STROKE,
-	HOLD,
 	HOLDING,
+	RELEASED,						// Ignores contact bounce
 };
 
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Hardware variables ----------------------------------------------
 
-flipperStates leftFlipperState = flipperStates::IDLE;
-flipperStates rightFlipperState = flipperStates::IDLE;
+struct sFlipper {
+	byte button;						// Must be on port D
+	byte coil;
+	volatile flipperStates state;
+	volatile byte ticks;
+};
 
-// Time variables
+sFlipper flippers[] = {
+	{leftButton, leftFlipper, flipperStates::IDLE, 0},
+	{rightButton, rightFlipper, flipperStates::IDLE, 0},
+};
 
-ulong leftButtonPreviousMs;
-ulong rightPreviousMs;
+volatile bool flippersEnabled = false;
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Interrupt handlers ----------------------------------------------
+
+// Pressing a button fires the coil right away. The 1 ms tick ends the stroke,
+// switches to holding power and notices the button being released, so none of
+// it waits for the main loop. After a release, edges are ignored until the
+// button has stayed up for RELEASE_TICKS, so contact bounce cannot fire again.
+
+static bool buttonDown(sFlipper *f)
+{
+	return !(PIND & bit(f->button));
+}
+
+static void fire(sFlipper *f)
+{
+	if(flippersEnabled && f->state == flipperStates::IDLE) {
+		digitalWrite(f->coil, HIGH);
+		f->ticks = 0;
+		f->state = flipperStates::STROKE;
+	}
+}
+
+static void release(sFlipper *f)
+{
+	digitalWrite(f->coil, LOW);
+	f->ticks = 0;
+	f->state = flipperStates::RELEASED;
+}
+
+static void tick(sFlipper *f)
+{
+	bool down = buttonDown(f);
+
+	switch(f->state) {
+
+		case flipperStates::IDLE:
+			if(!down) {
+				f->ticks = 0;
+			} else if(++f->ticks >= HELD_TICKS) {	// Held while being enabled
+				fire(f);
+			}
+			break;
+
+		case flipperStates::STROKE:
+			f->ticks++;
+			if(!down && f->ticks >= BOUNCE_TICKS) {
+				release(f);
+			} else if(f->ticks >= STROKE_TICKS) {
+				analogWrite(f->coil, HOLD_PWM);
+				f->state = flipperStates::HOLDING;
+			}
+			break;
+
+		case flipperStates::HOLDING:
+			if(!down) {
+				release(f);
+			}
+			break;
+
+		case flipperStates::RELEASED:
+			if(down) {
+				f->ticks = 0;
+			} else if(++f->ticks >= RELEASE_TICKS) {
+				f->ticks = 0;
+				f->state = flipperStates::IDLE;
+			}
+			break;
+	}
+}
+
+ISR(INT0_vect)
+{
+	PROFILE_ISR_ZONE(LEFT_FLIPPER);
+
+	fire(&flippers[0]);
+}
+
+ISR(INT1_vect)
+{
+	PROFILE_ISR_ZONE(RIGHT_FLIPPER);
+
+	fire(&flippers[1]);
+}
+
+ISR(TIMER0_COMPA_vect)
+{
+	if(flippersEnabled) {
+		PROFILE_ISR_ZONE(FLIPPER_TICK);
+
+		tick(&flippers[0]);
+		tick(&flippers[1]);
+	}
+}
 
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Methods ---------------------------------------------------------
 
-void Flippers::Reset()
+void Flippers::Init()
 {
-	digitalWrite(leftFlipper, LOW);
-	digitalWrite(rightFlipper, LOW);
+	EICRA = bit(ISC01) | bit(ISC11);		// Falling edges
+	EIFR = bit(INTF0) | bit(INTF1);
+	EIMSK = bit(INT0) | bit(INT1);
+
+	OCR0A = 0x80;
+	TIMSK0 |= bit(OCIE0A);
 }
 
-void Flippers::Left()
+// Turns both coils off and keeps them off until enabled again
+
+void Flippers::Reset()
 {
-	if(leftFlipperState == flipperStates::IDLE) {
-		if(LEFT_BUTTON_ON) {
-			digitalWrite(leftFlipper, HIGH);
-			leftButtonPreviousMs = millis();
-			leftFlipperState = flipperStates::STROKE;
-		}
-	} else if(leftFlipperState == flipperStates::STROKE) {
-		if(LEFT_BUTTON_OFF) {
-			digitalWrite(leftFlipper, LOW);
-			leftFlipperState = flipperStates::IDLE;
-		} else if(millis() - leftButtonPreviousMs >= MAX_POWER_MS) {
-			leftFlipperState = flipperStates::HOLD;
-		}
-	} else if(leftFlipperState == flipperStates::HOLD) {
-		if(LEFT_BUTTON_ON) {
-			analogWrite(leftFlipper, HOLD_PWM);
-		}
-		leftFlipperState = flipperStates::HOLDING;
-	} else if(leftFlipperState == flipperStates::HOLDING) {
-		if(LEFT_BUTTON_OFF) {
-			digitalWrite(leftFlipper, LOW);
-			leftFlipperState = flipperStates::IDLE;
-		}
+	noInterrupts();
+	flippersEnabled = false;
+	for(byte i = 0; i < NUMITEMS(flippers); i++) {
+		release(&flippers[i]);
 	}
+	interrupts();
 }
 
-void Flippers::Right()
+void Flippers::Enable(bool enable)
 {
-	if(rightFlipperState == flipperStates::IDLE) {
-		if(RIGHT_BUTTON_ON) {
-			digitalWrite(rightFlipper, HIGH);
-			rightPreviousMs = millis();
-			rightFlipperState = flipperStates::STROKE;
-		}
-	} else if(rightFlipperState == flipperStates::STROKE) {
-		if(RIGHT_BUTTON_OFF) {
-			digitalWrite(rightFlipper, LOW);
-			rightFlipperState = flipperStates::IDLE;
-		} else if(millis() - rightPreviousMs >= MAX_POWER_MS) {
-			rightFlipperState = flipperStates::HOLD;
-		}
-	} else if(rightFlipperState == flipperStates::HOLD) {
-		if(RIGHT_BUTTON_ON) {
-			analogWrite(rightFlipper, HOLD_PWM);
-		}
-		rightFlipperState = flipperStates::HOLDING;
-	} else if(rightFlipperState == flipperStates::HOLDING) {
-		if(RIGHT_BUTTON_OFF) {
-			digitalWrite(rightFlipper, LOW);
-			rightFlipperState = flipperStates::IDLE;
-		}
+	if(!enable) {
+		Reset();
+	} else {
+		flippersEnabled = true;
 	}
 }
 
@@ -13,9 +13,9 @@
 class Flippers
 {
   public:
+	static void Init();
 	static void Reset();
-	static void Left();
-	static void Right();
+	static void Enable(bool enable);
 };
 
 
@@ -11,22 +11,22 @@
 #define MAX_FREE_REPLAYS		2
 #define MAX_MULTIPLIER			8
 #define HOLD_THRESHOLD			3		// No. of stop sensor hits to activate hold
-#define BREAK_STREAK			14		// Spinner streak for higher scores
+#define BREAK_SPIN_RATE			8		// Spinner revolutions/s for higher scores
 
-// Points awarded
+// Points awarded, in packed BCD (see bcd.h)
 
-#define LEFT_ORBIT_POINTS		50
-#define HOLD_POINTS				1000
-#define HOLD_ACTIVE_POINTS		1250
-#define BALL_LOST_POINTS		250
-#define OUTLANE_POINTS			800
-#define SPINNER_POINTS			25
-#define SPINNER_BREAK_POINTS	200
-#define ROLLOVER_POINTS			50
-#define SKILL_SHOT_POINTS		1500
+#define LEFT_ORBIT_POINTS		0x50
+#define HOLD_POINTS				0x1000
+#define HOLD_ACTIVE_POINTS		0x1250
+#define BALL_LOST_POINTS		0x250
+#define OUTLANE_POINTS			0x800
+#define SPINNER_POINTS			0x25
+#define SPINNER_BREAK_POINTS	0x200
+#define ROLLOVER_POINTS			0x50
+#define SKILL_SHOT_POINTS		0x1500
 
-#define GREASY_SCORE			5000
-#define GREASY_BONUS			350
+#define GREASY_SCORE			0x5000
+#define GREASY_BONUS			0x350
 
 // Time constants
 
@@ -43,9 +43,10 @@
 #define NORMAL_ONESHOT			800
 #define NORMAL_FLASH_LEDS		200
 #define LEDS_ANIMATION_TIME		800
+#define GAME_OVER_FADE_TIME		3000	// Lights dim out while the final score shows
 #define MSG_END_GAME_TIME		1500
 #define MSG_END_SCORE_TIME		1500
 #define MSG_END_FLASH_TIME		250
 #define DEFAULT_DISPLAY_TIME	500
 #define LONG_DISPLAY_TIME		2000
-#define SPINNER_STREAK_TIMER	200
+#define SPINNER_STREAK_TIMER	200		// Longest gap between vanes of one spin
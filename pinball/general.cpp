@@ -5,13 +5,180 @@
 
 // -----------------------------------------------------------------------------
 
+#include <AsyncDelay.h>
+
 #include "general.h"
+#include "display.h"
+#include "messages.h"
+#include "motor.h"
+#include "servo.h"
+#include "spinner.h"
+#include "profiler.h"
+#include "telemetry.h"
+
+#pragma region Variables -------------------------------------------------------
+
+ulong childCmdsSent = 0;
+ulong childCmdsSuppressed = 0;
+
+// Commands for the child are packed together and sent once per loop pass
+
+byte childPacket[CHILD_PACKET_LENGTH];
+byte childPacketLength = 0;
+
+uint childDrops = 0;					// Twi::Drops(CHILD_ADDRESS) last seen
+uint childOverflows = 0;				// Packets the child had no room for
+AsyncDelay childPollTimer;
+
+extern Motor motor;
+extern Servo servo;
+extern Messages Msg;
+
+#pragma endregion --------------------------------------------------------------
 
 #pragma region Methods ---------------------------------------------------------
 
 void General::Reset()
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (int)childCommands::RESET);
+	Cmd((byte)childCommands::RESET);
+	Flush();
+	Forget();
+}
+
+void General::Send(const byte *cmd, byte n)
+{
+	PROFILE_ZONE(CHILD_SEND);
+
+	if(childPacketLength + n + 1 > CHILD_PACKET_LENGTH) {
+		Flush();
+	}
+
+	childPacket[childPacketLength++] = n;
+	memcpy(childPacket + childPacketLength, cmd, n);
+	childPacketLength += n;
+}
+
+void General::Cmd(byte cmd)
+{
+	Send(&cmd, 1);
+}
+
+void General::Cmd(byte cmd, int arg1)
+{
+	byte data[] = {cmd, (byte)arg1};
+	Send(data, sizeof data);
+}
+
+void General::Cmd(byte cmd, int arg1, int arg2)
+{
+	byte data[] = {cmd, (byte)arg1, (byte)arg2};
+	Send(data, sizeof data);
+}
+
+void General::Cmd(byte cmd, int arg1, int arg2, int arg3)
+{
+	byte data[] = {cmd, (byte)arg1, (byte)arg2, (byte)arg3};
+	Send(data, sizeof data);
+}
+
+// Called at the end of each loop pass. A packet that is not queued, that the
+// I²C queue later gives up on, or that the child has no room for leaves the
+// shadows wrong, so they are forgotten and the next commands go out whatever
+// they are. The child counts the packets it rejects and is read now and then.
+
+void General::Flush()
+{
+	byte reply[2];
+	uint drops;
+
+	if(childPacketLength) {
+		if(!Twi::Send(CHILD_ADDRESS, childPacket, childPacketLength)) {
+			Forget();
+		}
+		childPacketLength = 0;
+	}
+
+	drops = Twi::Drops(CHILD_ADDRESS);
+	if(drops != childDrops) {
+		childDrops = drops;
+		Forget();
+	}
+
+	if(Twi::Reply(reply, sizeof reply)) {
+		uint overflows = reply[0] | reply[1] << 8;
+		if(overflows != childOverflows) {
+			childOverflows = overflows;
+			Forget();
+		}
+	}
+
+	if(childPollTimer.isExpired() && Twi::Request(CHILD_ADDRESS, sizeof reply)) {
+		childPollTimer.start(CHILD_POLL_TIME, AsyncDelay::MILLIS);
+	}
+}
+
+void General::Forget()
+{
+	leds.Forget();
+	motor.Forget();
+	servo.Forget();
+}
+
+// Wrappers keep a shadow of the last state sent to the child and skip
+// commands that would not change it, unless forced
+
+bool General::Changed(uint *shadow, uint value, bool force)
+{
+	if(*shadow == value && !force) {
+		childCmdsSuppressed++;
+		return false;
+	}
+
+	*shadow = value;
+	childCmdsSent++;
+	return true;
+}
+
+void General::ShowStats()
+{
+	Serial.print(F("Child commands sent: "));
+	Serial.print(childCmdsSent);
+	Serial.print(F(", suppressed: "));
+	Serial.print(childCmdsSuppressed);
+	Serial.print(F(", packets rejected: "));
+	Serial.println(childOverflows);
+	Serial.print(F("I2C queue: "));
+	Serial.print(Twi::Depth());
+	Serial.print(F(", dropped: "));
+	Serial.println(Twi::Dropped());
+	Serial.print(F("I2C errors: child "));
+	Serial.print(Twi::Errors(CHILD_ADDRESS));
+	Serial.print(F(", display "));
+	Serial.print(Twi::Errors(SEVENSEGDISPLAY_ADR));
+	Serial.print(F(", bus cleared "));
+	Serial.println(Twi::Recoveries());
+	Serial.print(F("Spinner overflows: "));
+	Serial.println(Spinner::Overflows());
+	Serial.print(F("Messages dropped: "));
+	Serial.println(Msg.Dropped());
+	Serial.print(F("Telemetry frames: "));
+	Serial.print(Telemetry::Sent());
+	Serial.print(F(", dropped: "));
+	Serial.println(Telemetry::Dropped());
+}
+
+// Bytes between the heap and the stack. The host does not emulate SRAM.
+
+int General::FreeMemory()
+{
+#ifdef __AVR__
+	extern char __heap_start, *__brkval;
+	char top;
+
+	return &top - (__brkval ? __brkval : &__heap_start);
+#else
+	return 0;
+#endif
 }
 
 #pragma endregion --------------------------------------------------------------
@@ -9,11 +9,31 @@
 #define general_h
 
 #include "pinball.h"
+#include "twi.h"
+
+// Shadow value for a child output whose state is not known
+
+#define SHADOW_UNKNOWN			0xffff
+
+#define CHILD_POLL_TIME			100		// ms between reads of the child's overflow count
 
 class General
 {
   public:
 	static void Reset();
+	static void Send(const byte *cmd, byte n);
+	static void Cmd(byte cmd);
+	static void Cmd(byte cmd, int arg1);
+	static void Cmd(byte cmd, int arg1, int arg2);
+	static void Cmd(byte cmd, int arg1, int arg2, int arg3);
+	static void Flush();
+	static void Forget();
+	static bool Changed(uint *shadow, uint value, bool force = false);
+	static void ShowStats();
+	static int FreeMemory();
 };
 
+extern ulong childCmdsSent;
+extern ulong childCmdsSuppressed;
+
 #endif // general_h
@@ -0,0 +1,60 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Input port snapshot
+// Rubem Pechansky 2021
+
+// All switches are read once per loop pass, straight from the port registers,
+// and debounced together with a 2-bit vertical counter: a bit of stableInputs
+// follows portInputs once it has differed for 4 ticks in a row.
+
+// Ref.: http://www.dattalo.com/technical/software/pic/debounce.html
+
+// -----------------------------------------------------------------------------
+
+#include "inputs.h"
+#include "debounce.h"
+
+#pragma region Constants -------------------------------------------------------
+
+#define DEBOUNCE_TICKS			4
+#define DEBOUNCE_TICK_US		(DEFAULT_DEBOUNCE * 1000UL / DEBOUNCE_TICKS)
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Variables -------------------------------------------------------
+
+ulong portInputs;
+ulong stableInputs;
+
+ulong count0;
+ulong count1;
+ulong lastTickUs;
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Methods ---------------------------------------------------------
+
+void Inputs::Init()
+{
+	Read();
+	stableInputs = portInputs;
+	count0 = count1 = 0;
+}
+
+void Inputs::Read()
+{
+	portInputs = PIND | (ulong)PINB << 8 | (ulong)PINC << 16;
+
+	ulong us = micros();
+	if(us - lastTickUs < DEBOUNCE_TICK_US) {
+		return;
+	}
+	lastTickUs = us;
+
+	ulong delta = portInputs ^ stableInputs;
+	count1 = (count1 ^ count0) & delta;
+	count0 = ~count0 & delta;
+	stableInputs ^= delta & ~(count0 | count1);
+}
+
+#pragma endregion --------------------------------------------------------------
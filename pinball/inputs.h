@@ -0,0 +1,20 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Input port snapshot
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#ifndef inputs_h
+#define inputs_h
+
+#include "pinball.h"
+
+class Inputs
+{
+  public:
+	static void Init();
+	static void Read();
+};
+
+#endif // inputs_h
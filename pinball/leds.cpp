@@ -7,31 +7,127 @@
 
 #include "leds.h"
 #include "game.h"
+#include "general.h"
+
+#pragma region Constructor -----------------------------------------------------
+
+Leds::Leds()
+{
+	Forget();
+}
+
+// Next command to each LED is sent whatever it is
+
+void Leds::Forget()
+{
+	for(int i = 0; i < NLEDS; i++) {
+		shadow[i] = SHADOW_UNKNOWN;
+	}
+}
+
+#pragma endregion --------------------------------------------------------------
 
 #pragma region LED state functions ---------------------------------------------
 
 void Leds::On(childLeds led)
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (byte)childCommands::LED, (byte)led,
-		(byte)outState::ON, 0);
+	send(led, outState::ON, 0);
 }
 
 void Leds::Flash(childLeds led, uint time)
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (byte)childCommands::LED, (byte)led,
-		(byte)outState::FLASH, time / 100);
+	send(led, outState::FLASH, time / 100);
 }
 
 void Leds::OneShot(childLeds led, uint time)
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (byte)childCommands::LED, (byte)led,
-		(byte)outState::ONESHOT, time / 100);
+	send(led, outState::ONESHOT, time / 100);
 }
 
 void Leds::Off(childLeds led)
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (byte)childCommands::LED, (byte)led,
-		(byte)outState::OFF, 0);
+	send(led, outState::OFF, 0);
+}
+
+// Ramps the LED to a level (0-255) on the child. The next command to the LED
+// is always sent.
+
+void Leds::Fade(childLeds led, byte level, uint time)
+{
+	if((byte)led >= NLEDS) {
+		return;
+	}
+
+	General::Changed(&shadow[(byte)led], SHADOW_UNKNOWN, true);
+	General::Cmd((byte)childCommands::LED_FADE, (byte)led, level, time / 100);
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region LED frame functions ---------------------------------------------
+
+#define FRAME_KEEP				((uint)LED_KEEP << 8)
+
+void Leds::BeginFrame()
+{
+	for(int i = 0; i < NLEDS; i++) {
+		frame[i] = FRAME_KEEP;
+	}
+}
+
+void Leds::Set(childLeds led, outState state, uint time)
+{
+	if((byte)led < NLEDS) {
+		frame[(byte)led] = (byte)state << 8 | (byte)(time / 100);
+	}
+}
+
+// Sends only the LEDs that change; nothing at all if none does
+
+void Leds::SendFrame()
+{
+	byte cmd[LED_FRAME_LENGTH];
+	bool changed = false;
+
+	cmd[0] = (byte)childCommands::LED_FRAME;
+
+	for(int i = 0; i < NLEDS; i++) {
+		if(frame[i] != FRAME_KEEP && (frame[i] != shadow[i] ||
+			   highByte(frame[i]) == (byte)outState::ONESHOT)) {
+			shadow[i] = frame[i];
+			changed = true;
+		} else {
+			frame[i] = FRAME_KEEP;
+		}
+		cmd[1 + 2 * i] = highByte(frame[i]);
+		cmd[2 + 2 * i] = lowByte(frame[i]);
+	}
+
+	if(!changed) {
+		childCmdsSuppressed++;
+		return;
+	}
+
+	childCmdsSent++;
+	General::Send(cmd, sizeof cmd);
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Private methods -------------------------------------------------
+
+// One-shots restart the LED on the child, so they are always sent
+
+void Leds::send(childLeds led, outState state, byte time)
+{
+	if((byte)led >= NLEDS) {
+		return;
+	}
+
+	if(General::Changed(&shadow[(byte)led], (byte)state << 8 | time,
+		   state == outState::ONESHOT)) {
+		General::Cmd((byte)childCommands::LED, (byte)led, (byte)state, time);
+	}
 }
 
 #pragma endregion --------------------------------------------------------------
@@ -46,16 +142,13 @@ void Leds::waitAnimation()
 {
 	if(millis() > lastAnimMs + LEDS_ANIMATION_TIME) {
 
-		Off((childLeds)lLed);
-		On((childLeds)cLed);
-		Off((childLeds)(lLed + 4));
-		On((childLeds)(cLed + 4));
-
-		if(cLed % 2) {
-			On((childLeds)8);
-		} else {
-			Off((childLeds)8);
-		}
+		BeginFrame();
+		Set((childLeds)lLed, outState::OFF);
+		Set((childLeds)cLed, outState::ON);
+		Set((childLeds)(lLed + 4), outState::OFF);
+		Set((childLeds)(cLed + 4), outState::ON);
+		Set((childLeds)8, cLed % 2 ? outState::ON : outState::OFF);
+		SendFrame();
 
 		lastAnimMs = millis();
 		lLed = cLed;
@@ -65,18 +158,22 @@ void Leds::waitAnimation()
 
 void Leds::flashes(int time)
 {
+	BeginFrame();
 	for(int i = 0; i < NLEDS; i++) {
-		Flash((childLeds)i, time);
+		Set((childLeds)i, outState::FLASH, time);
 	}
+	SendFrame();
 }
 
 void Leds::allOff(bool lightsOff)
 {
+	BeginFrame();
 	for(int i = 0; i < NLEDS; i++) {
 		if(lightsOff || (childLeds)i != childLeds::LIGHTS) {
-			Off((childLeds)i);
+			Set((childLeds)i, outState::OFF);
 		}
 	}
+	SendFrame();
 }
 
 #pragma endregion --------------------------------------------------------------
@@ -13,10 +13,14 @@
 
 #include "Simpletypes.h"
 #include "pb_child.h"
+#include "twi.h"
 
 class Leds
 {
   public:
+	Leds();
+	void Forget();
+
 	void waitAnimation();
 	void flashes(int time);
 	void allOff(bool lightsOff);
@@ -25,6 +29,19 @@ class Leds
 	void Flash(childLeds led, uint time);
 	void OneShot(childLeds led, uint time);
 	void Off(childLeds led);
+	void Fade(childLeds led, byte level, uint time);
+
+	// Several LEDs at once, in a single command
+
+	void BeginFrame();
+	void Set(childLeds led, outState state, uint time = 0);
+	void SendFrame();
+
+  private:
+	void send(childLeds led, outState state, byte time);
+
+	uint shadow[NLEDS];
+	uint frame[NLEDS];
 };
 
 #endif // leds_h
@@ -0,0 +1,89 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Loop timing histograms
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#include "loopstats.h"
+#include "tests.h"
+
+#ifdef LOOP_STATS
+
+#pragma region Variables -------------------------------------------------------
+
+ulong passStartUs;
+ulong maxPassUs[NGAMESTATES];
+uint histogram[NGAMESTATES][LOOPSTATS_BUCKETS];
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Public methods --------------------------------------------------
+
+void LoopStats::Begin()
+{
+	passStartUs = micros();
+}
+
+void LoopStats::End(gameStates state)
+{
+	ulong us = micros() - passStartUs;
+	byte s = (byte)state - 1;
+	byte bucket = 0;
+
+	if(s >= NGAMESTATES) {
+		return;
+	}
+
+	if(us > maxPassUs[s]) {
+		maxPassUs[s] = us;
+	}
+
+	for(ulong n = us >> 1; n && bucket < LOOPSTATS_BUCKETS - 1; n >>= 1) {
+		bucket++;
+	}
+
+	if(histogram[s][bucket] < UINT_MAX) {
+		histogram[s][bucket]++;
+	}
+}
+
+void LoopStats::Dump()
+{
+	Serial.println(F("----- Loop timing (us) -----"));
+
+	for(byte s = 0; s < NGAMESTATES; s++) {
+		ulong passes = 0;
+		for(byte b = 0; b < LOOPSTATS_BUCKETS; b++) {
+			passes += histogram[s][b];
+		}
+		if(!passes) {
+			continue;
+		}
+
+		Serial.print(Tests::StateName((gameStates)(s + 1)));
+		Serial.print(F(": "));
+		Serial.print(passes);
+		Serial.print(F(" passes, max "));
+		Serial.println(maxPassUs[s]);
+
+		for(byte b = 0; b < LOOPSTATS_BUCKETS; b++) {
+			if(histogram[s][b]) {
+				Serial.print(F("  >= "));
+				Serial.print(b ? 1UL << b : 0UL);
+				Serial.print(F(": "));
+				Serial.println(histogram[s][b]);
+			}
+		}
+	}
+}
+
+void LoopStats::Clear()
+{
+	memset(maxPassUs, 0, sizeof maxPassUs);
+	memset(histogram, 0, sizeof histogram);
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#endif // LOOP_STATS
@@ -0,0 +1,33 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Loop timing histograms
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#ifndef loopstats_h
+#define loopstats_h
+
+#include "pinball.h"
+
+// Bucket n counts passes of 2^n to 2^(n+1)-1 µs; the last one takes the rest
+
+#define LOOPSTATS_BUCKETS		16
+
+class LoopStats
+{
+  public:
+#ifdef LOOP_STATS
+	static void Begin();
+	static void End(gameStates state);
+	static void Dump();
+	static void Clear();
+#else
+	static void Begin() {}
+	static void End(gameStates state) {}
+	static void Dump() {}
+	static void Clear() {}
+#endif
+};
+
+#endif // loopstats_h
@@ -7,6 +7,7 @@
 
 #include "messages.h"
 #include "game.h"
+#include "profiler.h"
 
 #pragma region Game constants ----------------------------------------------
 
@@ -16,15 +17,15 @@ uint ballLostCount = 0;
 uint replayCount = 0;
 uint endGameCount = 0;
 
-const char *ballLostMessages[] = {" OOPS", "UH-OH", " OUT"};
-const char *replayMessages[] = {"REPLAY", "AGAIN", "LUCKY", "SAVED"};
-const char *endGameMessages[] = {"  BYE", " CIAO", "Ended", "ADIOS", "  End", " LOST"};
+const char ballLostMessages[][MSG_TEXT_LENGTH + 1] PROGMEM = {" OOPS", "UH-OH", " OUT"};
+const char replayMessages[][MSG_TEXT_LENGTH + 1] PROGMEM = {"REPLAY", "AGAIN", "LUCKY", "SAVED"};
+const char endGameMessages[][MSG_TEXT_LENGTH + 1] PROGMEM = {"  BYE", " CIAO", "Ended", "ADIOS", "  End", " LOST"};
 
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Hardware variables ----------------------------------------------
 
-char displayBuffer[DISPLAYCHARS];
+char displayBuffer[DISPLAYCHARS + 1];
 
 #pragma endregion --------------------------------------------------------------
 
@@ -33,7 +34,7 @@ char displayBuffer[DISPLAYCHARS];
 extern byte currentBall;
 extern byte multiplier;
 extern byte stopSensorHits;
-extern ulong playerScore;
+extern bcd playerScore;
 
 #pragma endregion --------------------------------------------------------------
 
@@ -46,37 +47,35 @@ void Messages::Init()
 
 void Messages::Show(char *str)
 {
-	Display::Clear();
-	Display::Stop();
-	Display::Show(str);
+	display(str, false, msgModes::SHOW, 0);
+}
+
+void Messages::Show(const __FlashStringHelper *str)
+{
+	display((PGM_P)str, true, msgModes::SHOW, 0);
 }
 
-void Messages::Rotate(char *str, uint time = DEFAULT_ROTATE_TIME)
+void Messages::Rotate(const __FlashStringHelper *str, uint time = DEFAULT_ROTATE_TIME)
 {
-	Display::Clear();
-	Display::Show(str);
-	Display::Rotate(time);
+	display((PGM_P)str, true, msgModes::ROTATE, time);
 }
 
 void Messages::Flash(char *str, uint time = SLOW_FLASH_TIME)
 {
-	Display::Stop();
-	Display::Show(str);
-	Display::Flash(time);
+	display(str, false, msgModes::FLASH, time);
 }
 
 void Messages::ShowBonus()
 {
 	Display::Stop();
-	strcpy(displayBuffer, "BONUS");
-	Display::Show(displayBuffer);
+	Display::Show(F("BONUS"));
 	Display::Flash(SLOW_FLASH_TIME);
 }
 
 void Messages::ShowBall()
 {
 	Display::Stop();
-	strcpy(displayBuffer, "BALL  ");
+	strcpy_P(displayBuffer, PSTR("BALL  "));
 	displayBuffer[5] = '0' + currentBall;
 	Flash(displayBuffer, SLOW_FLASH_TIME);
 	// Display::Hold(1000);
@@ -84,7 +83,7 @@ void Messages::ShowBall()
 
 void Messages::ShowMultiplier()
 {
-	strcpy(displayBuffer, "MULT  ");
+	strcpy_P(displayBuffer, PSTR("MULT  "));
 	displayBuffer[5] = '0' + multiplier;
 	Display::Show(displayBuffer);
 	// Display::Hold(1000);
@@ -94,7 +93,7 @@ void Messages::ShowMultiplier()
 
 void Messages::ShowHoldState()
 {
-	strcpy(displayBuffer, "HOLD  ");
+	strcpy_P(displayBuffer, PSTR("HOLD  "));
 	displayBuffer[5] = '1' + stopSensorHits;
 	Display::Show(displayBuffer);
 	// Display::Hold(700);
@@ -104,14 +103,14 @@ void Messages::ShowHoldState()
 
 void Messages::ShowScore(bool flash = false)
 {
+	PROFILE_ZONE(SHOW_SCORE);
+
 	if(flash) {
-		delay(MSG_END_GAME_TIME);
-		Display::U2s(displayBuffer, playerScore);
-		Flash(displayBuffer, MSG_END_FLASH_TIME);
-		delay(MSG_END_SCORE_TIME);
+		Hold(MSG_END_GAME_TIME);
+		QueuePlayerScore(msgModes::FLASH, MSG_END_SCORE_TIME, MSG_END_FLASH_TIME);
 	} else {
 		Display::Stop();
-		Display::U2s(displayBuffer, playerScore);
+		Display::Bcd2s(displayBuffer, playerScore);
 		Display::Show(displayBuffer);
 	}
 }
@@ -133,11 +132,128 @@ void Messages::ShowEndGame()
 
 #pragma endregion --------------------------------------------------------------
 
+#pragma region Message queue ---------------------------------------------------
+
+// Queued steps are shown one after the other by Update(), each for its
+// duration, without blocking the game loop
+
+void Messages::Queue(char *str, msgModes mode, uint duration, uint time = 0)
+{
+	enqueue(str, false, mode, duration, time);
+}
+
+void Messages::Queue(const __FlashStringHelper *str, msgModes mode, uint duration, uint time = 0)
+{
+	enqueue((PGM_P)str, true, mode, duration, time);
+}
+
+// Shows a score as it is now. There is one copy for all such steps, so only
+// the last one queued is kept.
+
+void Messages::QueueScore(bcd score, msgModes mode, uint duration, uint time = 0)
+{
+	Display::Bcd2s(queuedScore, score);
+	queuedScore[DISPLAYCHARS] = '\0';
+	enqueue(queuedScore, false, mode, duration, time);
+}
+
+// Shows playerScore as it is when the step comes up, so it takes no copy
+
+void Messages::QueuePlayerScore(msgModes mode, uint duration, uint time = 0)
+{
+	enqueue(NULL, false, mode, duration, time);
+}
+
+void Messages::Hold(uint duration)
+{
+	enqueue(NULL, false, msgModes::HOLD, duration, 0);
+}
+
+void Messages::Update()
+{
+	Display::Update();
+
+	if(!queueCount || !stepTimer.isExpired()) {
+		return;
+	}
+
+	msgStep *step = &queue[queueHead];
+	queueHead = (queueHead + 1) % MSG_QUEUE_LENGTH;
+	queueCount--;
+
+	if(step->mode != msgModes::HOLD) {
+		const char *text = step->text;
+		if(!text) {
+			Display::Bcd2s(displayBuffer, playerScore);
+			text = displayBuffer;
+		}
+		display(text, step->inFlash, step->mode, step->time);
+	}
+
+	stepTimer.start(step->duration, AsyncDelay::MILLIS);
+	Display::Update();
+}
+
+bool Messages::Busy()
+{
+	return queueCount || !stepTimer.isExpired();
+}
+
+uint Messages::Dropped()
+{
+	return queueDropped;
+}
+
+#pragma endregion --------------------------------------------------------------
+
 #pragma region Private methods --------------------------------------------------
 
-void Messages::showMultiString(const char *str[], uint nItems, uint *index)
+void Messages::display(const char *str, bool inFlash, msgModes mode, uint time)
+{
+	if(mode != msgModes::FLASH) {
+		Display::Clear();
+	}
+	if(mode != msgModes::ROTATE) {
+		Display::Stop();
+	}
+
+	if(inFlash) {
+		Display::Show((const __FlashStringHelper *)str);
+	} else {
+		Display::Show((char *)str);
+	}
+
+	if(mode == msgModes::FLASH) {
+		Display::Flash(time);
+	} else if(mode == msgModes::ROTATE) {
+		Display::Rotate(time);
+	}
+}
+
+// A full queue drops the step, so a sequence shows with a gap; ShowStats
+// reports how often
+
+void Messages::enqueue(const char *str, bool inFlash, msgModes mode, uint duration, uint time)
+{
+	if(queueCount == MSG_QUEUE_LENGTH) {
+		queueDropped++;
+		return;
+	}
+
+	msgStep *step = &queue[(queueHead + queueCount) % MSG_QUEUE_LENGTH];
+	step->text = str;
+	step->inFlash = inFlash;
+	step->mode = mode;
+	step->time = time;
+	step->duration = duration;
+	queueCount++;
+
+	Update();
+}
+
+void Messages::showMultiString(const char str[][MSG_TEXT_LENGTH + 1], uint nItems, uint *index)
 {
-	Display::Show((char *)str[*index % nItems]);
+	Display::Show((const __FlashStringHelper *)str[*index % nItems]);
 	(*index)++;
 }
 
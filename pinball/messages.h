@@ -8,18 +8,41 @@
 #ifndef messages_h
 #define messages_h
 
+#include <AsyncDelay.h>
+
 #include "pinball.h"
 #include "display.h"
 
 #define DEFAULT_ROTATE_TIME			200
 #define SLOW_FLASH_TIME			600
+#define MSG_QUEUE_LENGTH		8		// The game over sequence takes 8 steps
+#define MSG_TEXT_LENGTH			6		// Longest of the multi-messages
+
+// Display modes for queued messages
+
+enum class msgModes : byte
+{
+	HOLD = 0,				// Keep what is being shown
+	SHOW,
+	FLASH,
+	ROTATE,
+};
+
+struct msgStep {
+	const char *text;		// Must outlive the step; NULL shows playerScore
+	bool inFlash;			// text is a F() string
+	msgModes mode;
+	uint time;				// Flash or rotate period
+	uint duration;
+};
 
 class Messages
 {
   public:
 	void Init();
 	void Show(char *str);
-	void Rotate(char *str, uint time = DEFAULT_ROTATE_TIME);
+	void Show(const __FlashStringHelper *str);
+	void Rotate(const __FlashStringHelper *str, uint time = DEFAULT_ROTATE_TIME);
 	void Flash(char *str, uint time = SLOW_FLASH_TIME);
 	void ShowBonus();
 	void ShowBall();
@@ -30,8 +53,26 @@ class Messages
 	void ShowBallLost();
 	void ShowEndGame();
 
+	void Queue(char *str, msgModes mode, uint duration, uint time = 0);
+	void Queue(const __FlashStringHelper *str, msgModes mode, uint duration, uint time = 0);
+	void QueueScore(bcd score, msgModes mode, uint duration, uint time = 0);
+	void QueuePlayerScore(msgModes mode, uint duration, uint time = 0);
+	void Hold(uint duration);
+	void Update();
+	bool Busy();
+	uint Dropped();
+
   private:
-	void showMultiString(const char *str[], uint nItems, uint *index);
+	void display(const char *str, bool inFlash, msgModes mode, uint time);
+	void enqueue(const char *str, bool inFlash, msgModes mode, uint duration, uint time);
+	void showMultiString(const char str[][MSG_TEXT_LENGTH + 1], uint nItems, uint *index);
+
+	msgStep queue[MSG_QUEUE_LENGTH];
+	byte queueHead = 0;
+	byte queueCount = 0;
+	uint queueDropped = 0;				// Steps that found the queue full
+	char queuedScore[DISPLAYCHARS + 1];	// Shared by the QueueScore() steps
+	AsyncDelay stepTimer;
 };
 
 #endif // messages_h
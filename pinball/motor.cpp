@@ -6,10 +6,12 @@
 // -----------------------------------------------------------------------------
 
 #include "motor.h"
+#include "telemetry.h"
 
 #pragma region Constants -------------------------------------------------------
 
 #define FEEDBALL_TIME			100
+#define FEEDBALL_TIMEOUT		3000
 
 #pragma endregion --------------------------------------------------------------
 
@@ -17,12 +19,52 @@
 
 void Motor::FeedBall()
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (int)childCommands::MOTOR, HIGH);
-	delay(FEEDBALL_TIME);
-	while(digitalRead(feederHomeSensor)) {
-		delay(5);
+	feeding = true;
+	TASK_RESET(feedTask);
+	Update();
+}
+
+void Motor::Update()
+{
+	if(!feeding) {
+		return;
+	}
+
+	TASK_BEGIN(feedTask);
+
+	send(HIGH);
+	TASK_SLEEP(feedTask, FEEDBALL_TIME);
+
+	// Run until the feeder is back home, but never forever
+
+	feedTimeout.start(FEEDBALL_TIMEOUT, AsyncDelay::MILLIS);
+	TASK_WAIT_UNTIL(feedTask, !PIN_HIGH(feederHomeSensor) || feedTimeout.isExpired());
+	send(LOW);
+	if(feedTimeout.isExpired()) {
+		Telemetry::Send(telemetryEvents::FEEDER_TIMEOUT);
+	}
+	feeding = false;
+
+	TASK_END(feedTask);
+}
+
+bool Motor::Feeding()
+{
+	return feeding;
+}
+
+// Next command is sent whatever it is
+
+void Motor::Forget()
+{
+	shadow = SHADOW_UNKNOWN;
+}
+
+void Motor::send(byte state)
+{
+	if(General::Changed(&shadow, state)) {
+		General::Cmd((byte)childCommands::MOTOR, state);
 	}
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (int)childCommands::MOTOR, LOW);
 }
 
 #pragma endregion --------------------------------------------------------------
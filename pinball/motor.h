@@ -9,11 +9,24 @@
 #define motor_h
 
 #include "pinball.h"
+#include "general.h"
+#include "task.h"
 
 class Motor
 {
   public:
 	void FeedBall();
+	void Update();
+	bool Feeding();
+	void Forget();
+
+  private:
+	void send(byte state);
+
+	task feedTask;
+	AsyncDelay feedTimeout;
+	bool feeding = false;
+	uint shadow = SHADOW_UNKNOWN;
 };
 
 #endif // motor_h
@@ -14,6 +14,8 @@
 #include "Simpletypes.h"
 #include "pb_child.h"
 
+#include "bcd.h"
+
 #include "leds.h"
 
 // Hardware constants
@@ -21,6 +23,11 @@
 #define SEVENSEGDISPLAY_ADR		0x09
 #define DISPLAYCHARS			6
 
+// Instrumentation
+
+// #define LOOP_STATS					// Uncomment to collect loop timing histograms
+// #define PROFILER						// Uncomment to record hot-path zones
+
 // Enums
 
 enum class gameStates
@@ -37,6 +44,20 @@ enum class gameStates
 	GAME_OVER,
 };
 
+#define NGAMESTATES			((int)gameStates::GAME_OVER)
+#define NO_GAME_STATE		((gameStates)0)
+
+// What each game state does: once on entering, once per loop pass and once on
+// leaving. Any of them may be NULL.
+
+struct stateHandlers {
+	gameStates state;
+	void (*onEnter)();
+	void (*onUpdate)();
+	void (*onExit)();
+	bool flippers;					// Flippers work in this state
+};
+
 // Arduino pin assignments
 
 const byte leftButton = 2;
@@ -65,20 +86,27 @@ const byte launchSensor = A7;
 #define LAUNCH_SENSOR_THRESHOLD 600
 #define HOLD_SENSOR_THRESHOLD	600
 
-// Sensor macros
+// Input snapshot bits: PIND is pins 0-7, PINB 8-13, PINC A0-A5 (bits 16-21).
+// A6 and A7 are analog only but get bits 22-23 for debounce state.
 
-#define LEFT_BUTTON_ON		(!digitalRead(leftButton))
-#define RIGHT_BUTTON_ON		(!digitalRead(rightButton))
-#define LEFT_BUTTON_OFF		(digitalRead(leftButton))
-#define RIGHT_BUTTON_OFF	(digitalRead(rightButton))
-#define IS_BALL_LOST		(digitalRead(ballLostSensor))
+#define PIN_MASK(pin)		(1UL << ((pin) < A0 ? (pin) : (pin) + 2))
+#define PIN_HIGH(pin)		((portInputs & PIN_MASK(pin)) != 0)
+#define PIN_STABLE(pin)		((stableInputs & PIN_MASK(pin)) != 0)
+
+// Sensor macros
 
-#define ARDUINO_PINS		(A7 + 1)
+#define LEFT_BUTTON_ON		(!PIN_HIGH(leftButton))
+#define RIGHT_BUTTON_ON		(!PIN_HIGH(rightButton))
+#define LEFT_BUTTON_OFF		(PIN_HIGH(leftButton))
+#define RIGHT_BUTTON_OFF	(PIN_HIGH(rightButton))
+#define IS_BALL_LOST		(PIN_HIGH(ballLostSensor))
 
 // Global variables
 
 extern Leds leds;
 extern char displayBuffer[];
-extern uint sensorState[ARDUINO_PINS];
+extern ulong portInputs;
+extern ulong stableInputs;
+extern ulong sensorState;
 
 #endif // pinball_h
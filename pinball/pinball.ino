@@ -5,22 +5,29 @@
 
 // -----------------------------------------------------------------------------
 
-#include <Wire.h>
 #include <AsyncDelay.h>
 
 #include "pinball.h"
 
+#include "adc.h"
 #include "debounce.h"
 #include "flippers.h"
 #include "game.h"
 #include "general.h"
+#include "inputs.h"
 #include "leds.h"
+#include "loopstats.h"
 #include "messages.h"
 #include "motor.h"
+#include "profiler.h"
 #include "sensors.h"
 #include "servo.h"
 #include "sound.h"
+#include "spinner.h"
+#include "task.h"
+#include "telemetry.h"
 #include "tests.h"
+#include "twi.h"
 
 #pragma region Hardware constants ----------------------------------------------
 
@@ -66,7 +73,10 @@ Servo servo;
 // Time variables
 
 AsyncDelay freeReplayTimer;
-AsyncDelay servoTimer;
+
+// Resumable task for the states that have to wait
+
+task stateTask;
 
 extern AsyncDelay skillShotTimer;
 
@@ -74,8 +84,8 @@ extern AsyncDelay skillShotTimer;
 
 #pragma region Game variables --------------------------------------------------
 
-gameStates gameState = (gameStates)-1;
-gameStates lastGameState = (gameStates)-2;
+gameStates gameState = NO_GAME_STATE;
+gameStates nextGameState = NO_GAME_STATE;
 byte currentBall = 1;
 byte multiplier = 1;
 byte freeReplays = 0;
@@ -85,11 +95,12 @@ extraBallStates extraBallState = extraBallStates::NOEXTRABALL;
 bool skillShotActive = false;
 bool holdActive = false;
 bool greasyActive = false;
+bool attractLeds = false;				// LEDs reset for the attract animation
 
-ulong playerScore = 0;
-ulong lastScore = 0;
-ulong greasyScore = 0;
-ulong eobBonus = 0;
+bcd playerScore = 0;
+bcd lastScore = 0;
+bcd greasyScore = 0;
+bcd eobBonus = 0;
 
 #pragma endregion --------------------------------------------------------------
 
@@ -100,14 +111,23 @@ void setup()
 	// Initialize
 
 	Serial.begin(BAUDRATE);
-	Wire.begin();
+	Twi::Init();
 
 	setPinModes();
+	Inputs::Init();
+	Flippers::Init();
+	registerSensors();
+	Spinner::Init();
+	Adc::Init();
 	General::Reset();
 	Msg.Init();
 
-	preStartGame();
+	Serial.print(F("Free RAM: "));
+	Serial.println(General::FreeMemory());
+
+	delay(TABLE_START_DELAY);
 	setGameState(gameStates::GAME_START);
+	updateGameState();
 }
 
 void setPinModes()
@@ -128,11 +148,47 @@ void setPinModes()
 
 #pragma endregion --------------------------------------------------------------
 
+#pragma region State table ----------------------------------------------------
+
+// One entry per gameStates value, in order
+
+constexpr stateHandlers stateTable[] = {
+	//	State						onEnter			onUpdate		onExit			Flippers
+	{gameStates::GAME_START,		preStartGame,	gameStart,		NULL,			false},
+	{gameStates::BALL_START,		NULL,			ballStart,		NULL,			true},
+	{gameStates::LAUNCHING,			Spinner::Flush,	launching,		NULL,			true},
+	{gameStates::PLAYING,			NULL,			playing,		stopPlaying,	true},
+	{gameStates::NO_MORE_POINTS,	resetLeds,		noMorePoints,	NULL,			false},
+	{gameStates::BALL_LOST,			ballLost,		NULL,			NULL,			false},
+	{gameStates::SAVE_BALL,			saveBall,		NULL,			NULL,			false},
+	{gameStates::NEXT_BALL,			nextBall,		NULL,			NULL,			false},
+	{gameStates::BALL_NEAR_HOME,	NULL,			ballNearHome,	NULL,			true},
+	{gameStates::GAME_OVER,			gameOver,		NULL,			NULL,			false},
+};
+
+constexpr bool stateTableInOrder(int i)
+{
+	return i == NGAMESTATES || ((int)stateTable[i].state == i + 1 && stateTableInOrder(i + 1));
+}
+
+static_assert(NUMITEMS(stateTable) == NGAMESTATES, "stateTable[] must have one entry per game state");
+static_assert(stateTableInOrder(0), "stateTable[] must list the game states in order");
+
+#pragma endregion --------------------------------------------------------------
+
 #pragma region Main loop -------------------------------------------------------
 
 void loop()
 {
+	// Each of these runs once per pass and must never block
+
+	Inputs::Read();
 	gameLoop();
+	Msg.Update();
+	motor.Update();
+	General::Flush();
+	Twi::Update();
+	checkSerialCommands();
 
 	// Tests::Leds();
 	// Tests::Sounds();
@@ -143,47 +199,23 @@ void loop()
 
 void gameLoop()
 {
-	switch((gameStates)gameState) {
-
-		case gameStates::GAME_START:
-			gameStart();
-			break;
-
-		case gameStates::BALL_START:
-			ballStart();
-			break;
-
-		case gameStates::LAUNCHING:
-			launching();
-			break;
-
-		case gameStates::PLAYING:
-			playing();
-			break;
+	// A transition is timed with the pass of the state it enters
 
-		case gameStates::NO_MORE_POINTS:
-			noMorePoints();
-			break;
+	LoopStats::Begin();
 
-		case gameStates::BALL_LOST:
-			ballLost();
-			break;
-
-		case gameStates::SAVE_BALL:
-			saveBall();
-			break;
+	updateGameState();
 
-		case gameStates::NEXT_BALL:
-			nextBall();
-			break;
+	gameStates state = gameState;
+	void (*onUpdate)() = stateTable[(int)state - 1].onUpdate;
 
-		case gameStates::BALL_NEAR_HOME:
-			ballNearHome();
-			break;
+	if(onUpdate) {
+		onUpdate();
+	}
 
-		case gameStates::GAME_OVER:
-			gameOver();
-			break;
+	LoopStats::End(state);
+	if(state == gameStates::GAME_OVER) {
+		LoopStats::Dump();
+		LoopStats::Clear();
 	}
 }
 
@@ -191,10 +223,22 @@ void gameLoop()
 
 #pragma region State machine functions -----------------------------------------
 
+// The LEDs are reset only once the last game's messages are over, so the
+// lights can fade out meanwhile
+
 void gameStart()
 {
+	if(Msg.Busy()) {
+		return;
+	}
+
+	if(!attractLeds) {
+		resetLeds();
+		attractLeds = true;
+	}
+
 	if(checkButtons()) {
-		Msg.Show("START");
+		Msg.Show(F("START"));
 		Sound::Play(soundNames::CABINET);
 		currentBall = 1;
 		multiplier = 1;
@@ -210,7 +254,11 @@ void gameStart()
 
 void ballStart()
 {
+	TASK_BEGIN(stateTask);
+
 	motor.FeedBall();
+	TASK_WAIT_UNTIL(stateTask, !motor.Feeding());
+
 	resetLeds();
 	skillShotActive = false;
 	holdActive = false;
@@ -220,7 +268,6 @@ void ballStart()
 	greasyActive = false;
 	resetRollovers();
 	servo.OpenDoor();
-	servoTimer.start(SERVO_TIMER, AsyncDelay::MILLIS);
 	leds.Off(childLeds::LEFT_OUTLANE);
 	leds.Off(childLeds::RIGHT_OUTLANE);
 	leds.Flash(childLeds::ROLLOVER_SKILL, NORMAL_FLASH_LEDS);
@@ -229,42 +276,35 @@ void ballStart()
 	Msg.ShowBall();
 
 	// Wait for servo door to open before changing state
-	while(!servoTimer.isExpired()) {
-		Flippers::Left();
-		Flippers::Right();
-	};
+	TASK_SLEEP(stateTask, SERVO_TIMER);
 	setGameState(gameStates::LAUNCHING);
+
+	TASK_END(stateTask);
 }
 
 void launching()
 {
-	Flippers::Left();
-	Flippers::Right();
-
-	if(checkLaunch()) {
-		skillShotTimer.start(SKILL_SHOT_TIME, AsyncDelay::MILLIS);
-		freeReplayTimer.start(BALL_SAVER_TIME, AsyncDelay::MILLIS);
-		servo.CloseDoor();
-		servoTimer.start(SERVO_TIMER, AsyncDelay::MILLIS);
-		lastScore = playerScore;
-		skillShotActive = true;
-		Msg.ShowScore();
-		Sound::Play(soundNames::FAUCET);
-
-		// Wait for servo door to close before changing state
-		while(!servoTimer.isExpired()) {
-			Flippers::Left();
-			Flippers::Right();
-		};
-		setGameState(gameStates::PLAYING);
-	}
+	TASK_BEGIN(stateTask);
+
+	TASK_WAIT_UNTIL(stateTask, checkLaunch());
+
+	skillShotTimer.start(SKILL_SHOT_TIME, AsyncDelay::MILLIS);
+	freeReplayTimer.start(BALL_SAVER_TIME, AsyncDelay::MILLIS);
+	servo.CloseDoor();
+	lastScore = playerScore;
+	skillShotActive = true;
+	Msg.ShowScore();
+	Sound::Play(soundNames::FAUCET);
+
+	// Wait for servo door to close before changing state
+	TASK_SLEEP(stateTask, SERVO_TIMER);
+	setGameState(gameStates::PLAYING);
+
+	TASK_END(stateTask);
 }
 
 void playing()
 {
-	Flippers::Left();
-	Flippers::Right();
-
 	checkOrbitSensor();
 	checkRollovers();
 	checkSkillShot();
@@ -278,9 +318,13 @@ void playing()
 	}
 }
 
+void stopPlaying()
+{
+	digitalWrite(stopMagnet, LOW);
+}
+
 void noMorePoints()
 {
-	resetLeds();
 	if(IS_BALL_LOST) {
 		setGameState(gameStates::BALL_LOST);
 	}
@@ -300,8 +344,6 @@ void ballLost()
 			setGameState(gameStates::NEXT_BALL);
 		} else {
 			setGameState(gameStates::GAME_OVER);
-			Serial.println("-----*****-----*****-----*****-----");
-			Serial.println();
 		}
 	}
 }
@@ -321,7 +363,7 @@ void nextBall()
 {
 	Msg.ShowBallLost();
 	Sound::Play(soundNames::DRAIN);
-	delay(DEFAULT_DISPLAY_TIME);
+	Msg.Hold(DEFAULT_DISPLAY_TIME);
 	showBallScore(false);
 	currentBall++;
 	freeReplays = 0;
@@ -331,19 +373,26 @@ void nextBall()
 
 void ballNearHome()
 {
-	delay(BALL_LOST_TIMEOUT);
-	Msg.Rotate("_-@-_-@-");
-	delay(BALL_NEAR_HOME_TIME);
+	TASK_BEGIN(stateTask);
+
+	// Let the end-of-ball messages finish
+	TASK_WAIT_UNTIL(stateTask, !Msg.Busy());
+
+	TASK_SLEEP(stateTask, BALL_LOST_TIMEOUT);
+	Msg.Rotate(F("_-@-_-@-"));
+	TASK_SLEEP(stateTask, BALL_NEAR_HOME_TIME);
 	setGameState(gameStates::BALL_START);
+
+	TASK_END(stateTask);
 }
 
 void gameOver()
 {
 	Msg.ShowEndGame();
 	Sound::Play(soundNames::CRASH);
-	delay(DEFAULT_DISPLAY_TIME);
+	leds.Fade(childLeds::LIGHTS, 0, GAME_OVER_FADE_TIME);
+	Msg.Hold(DEFAULT_DISPLAY_TIME);
 	showBallScore(true);
-	preStartGame();
 	setGameState(gameStates::GAME_START);
 }
 
@@ -351,10 +400,13 @@ void gameOver()
 
 #pragma region Auxiliary functions ---------------------------------------------
 
-void incrementScore(ulong points)
+void incrementScore(bcd points)
 {
-	playerScore += points * multiplier;
-	greasyScore += points * multiplier;
+	PROFILE_ZONE(INCREMENT_SCORE);
+
+	points = Bcd::Mul(points, multiplier);
+	playerScore = Bcd::Add(playerScore, points);
+	greasyScore = Bcd::Add(greasyScore, points);
 
 	if(!greasyActive && greasyScore >= GREASY_SCORE) {
 		greasyActive = true;
@@ -364,47 +416,89 @@ void incrementScore(ulong points)
 
 void resetLeds()
 {
-	leds.On(childLeds::LIGHTS);
-
+	leds.BeginFrame();
+	leds.Set(childLeds::LIGHTS, outState::ON);
 	for(int i = 0; i <= 7; i++) {
-		leds.Off((childLeds)i);
+		leds.Set((childLeds)i, outState::OFF);
 	}
+	leds.SendFrame();
 }
 
+// The change takes place at the start of the next pass
+
 void setGameState(gameStates state)
 {
-	gameState = state;
-	if(lastGameState != state) {
-		Tests::GameState(state);			// Uncomment this line for debug
-		lastGameState = state;
+	nextGameState = state;
+}
+
+void updateGameState()
+{
+	if(nextGameState == gameState) {
+		return;
+	}
+
+	if(gameState != NO_GAME_STATE && stateTable[(int)gameState - 1].onExit) {
+		stateTable[(int)gameState - 1].onExit();
+	}
+
+	gameState = nextGameState;
+	const stateHandlers *handlers = &stateTable[(int)gameState - 1];
+
+	TASK_RESET(stateTask);
+	Flippers::Enable(handlers->flippers);
+	Telemetry::Send(telemetryEvents::GAME_STATE, (byte)gameState);
+
+	if(handlers->onEnter) {
+		handlers->onEnter();
 	}
 }
 
 void preStartGame()
 {
-	resetLeds();
-	Msg.Rotate("oooooo*oooooo******o******");
-	//          1234567890123456789012345678901
+	attractLeds = false;
+	Msg.Queue(F("oooooo*oooooo******o******"), msgModes::ROTATE, 0, DEFAULT_ROTATE_TIME);
+	//         1234567890123456789012345678901
 	servo.CloseDoor();
-	delay(TABLE_START_DELAY);
+}
+
+void checkSerialCommands()
+{
+	if(!Serial.available()) {
+		return;
+	}
+
+	switch(Serial.read()) {
+		case 'h':
+			LoopStats::Dump();
+			break;
+		case 'c':
+			LoopStats::Clear();
+			break;
+		case 's':
+			General::ShowStats();
+			break;
+		case 'p':
+			Profiler::Dump();
+			break;
+	}
 }
 
 void showBallScore(bool gameOver)
 {
+	// Queued, so the game loop keeps running while it is shown
+
 	if(eobBonus) {
-		Msg.ShowBonus();
-		delay(DEFAULT_DISPLAY_TIME);
-		ulong score = playerScore;
-		playerScore = eobBonus;
-		Msg.ShowScore();
-		playerScore = score;
-		delay(DEFAULT_DISPLAY_TIME);
+		Msg.Queue(F("BONUS"), msgModes::FLASH, DEFAULT_DISPLAY_TIME, SLOW_FLASH_TIME);
+		Msg.QueueScore(eobBonus, msgModes::SHOW, DEFAULT_DISPLAY_TIME);
 		incrementScore(eobBonus);
 	}
-	Msg.Show("SCORE");
-	delay(DEFAULT_DISPLAY_TIME);
-	Msg.ShowScore(gameOver);
-	delay(gameOver ? LONG_DISPLAY_TIME : 0);
+	Msg.Queue(F("SCORE"), msgModes::SHOW, DEFAULT_DISPLAY_TIME);
+	if(gameOver) {
+		Msg.ShowScore(true);
+		Msg.Hold(LONG_DISPLAY_TIME);
+	} else {
+		Msg.QueuePlayerScore(msgModes::SHOW, 0);
+	}
 }
 
 #pragma endregion --------------------------------------------------------------
@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Hot-path zone profiler
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#include "profiler.h"
+
+#ifdef PROFILER
+
+#pragma region Constants -------------------------------------------------------
+
+// Flags in profileEvent.zone
+
+#define PROFILE_END				0x80
+#define PROFILE_ISR				0x40
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Variables -------------------------------------------------------
+
+struct profileEvent {
+	ulong us;
+	byte zone;
+};
+
+#define ZONE_NAME_LENGTH		16
+
+const char zoneNames[][ZONE_NAME_LENGTH + 1] PROGMEM = {
+	"leftFlipper",
+	"rightFlipper",
+	"flipperTick",
+	"checkButtons",
+	"checkOrbitSensor",
+	"checkRollovers",
+	"checkSkillShot",
+	"checkStopMagnet",
+	"checkSpinner",
+	"checkOutlanes",
+	"checkBallLost",
+	"checkLaunch",
+	"incrementScore",
+	"Msg.ShowScore",
+	"General::Send",
+	"Twi::Send",
+};
+
+static_assert(NUMITEMS(zoneNames) == NPROFILEZONES, "zoneNames[] must have one entry per zone");
+
+// Oldest events are overwritten first
+
+profileEvent profileEvents[PROFILER_EVENTS];
+volatile byte profileHead = 0;
+volatile byte profileCount = 0;
+volatile bool profilePaused = false;
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Public methods --------------------------------------------------
+
+void Profiler::Mark(profileZones zone, bool end, bool isr)
+{
+	if(!isr) {
+		noInterrupts();
+	}
+
+	if(!profilePaused) {
+		profileEvent *e = &profileEvents[profileHead];
+
+		e->us = micros();
+		e->zone = (byte)zone | (end ? PROFILE_END : 0) | (isr ? PROFILE_ISR : 0);
+		profileHead = (profileHead + 1) % PROFILER_EVENTS;
+		if(profileCount < PROFILER_EVENTS) {
+			profileCount++;
+		}
+	}
+
+	if(!isr) {
+		interrupts();
+	}
+}
+
+// One line per event: time in µs, B(egin) or E(nd), thread (1 = loop,
+// 2 = interrupts) and zone name. Recording stops while dumping.
+
+void Profiler::Dump()
+{
+	profilePaused = true;
+
+	Serial.println(F("----- Profile (us) -----"));
+
+	byte i = (profileHead + PROFILER_EVENTS - profileCount) % PROFILER_EVENTS;
+	for(byte n = 0; n < profileCount; n++) {
+		profileEvent *e = &profileEvents[i];
+
+		Serial.print(e->us);
+		Serial.print(e->zone & PROFILE_END ? F(" E ") : F(" B "));
+		Serial.print(e->zone & PROFILE_ISR ? F("2 ") : F("1 "));
+		Serial.println((const __FlashStringHelper *)zoneNames[e->zone & ~(PROFILE_END | PROFILE_ISR)]);
+		i = (i + 1) % PROFILER_EVENTS;
+	}
+
+	Serial.println(F("----- End of profile -----"));
+
+	profileCount = 0;
+	profilePaused = false;
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#endif // PROFILER
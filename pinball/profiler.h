@@ -0,0 +1,86 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Hot-path zone profiler
+// Rubem Pechansky 2021
+
+// Each zone records its begin and end times into a RAM ring; the 'p' serial
+// command dumps the ring and host/trace.cpp turns the dump into a Chrome trace.
+// Without PROFILER the zone macros expand to nothing.
+
+// -----------------------------------------------------------------------------
+
+#ifndef profiler_h
+#define profiler_h
+
+#include "pinball.h"
+
+#define PROFILER_EVENTS			64		// 5 bytes each
+
+// Profiled zones. Keep zoneNames[] in profiler.cpp in the same order.
+
+enum class profileZones : byte
+{
+	LEFT_FLIPPER,
+	RIGHT_FLIPPER,
+	FLIPPER_TICK,
+	CHECK_BUTTONS,
+	CHECK_ORBIT_SENSOR,
+	CHECK_ROLLOVERS,
+	CHECK_SKILL_SHOT,
+	CHECK_STOP_MAGNET,
+	CHECK_SPINNER,
+	CHECK_OUTLANES,
+	CHECK_BALL_LOST,
+	CHECK_LAUNCH,
+	INCREMENT_SCORE,
+	SHOW_SCORE,
+	CHILD_SEND,
+	TWI_SEND,
+};
+
+#define NPROFILEZONES			((int)profileZones::TWI_SEND + 1)
+
+class Profiler
+{
+  public:
+#ifdef PROFILER
+	static void Mark(profileZones zone, bool end, bool isr);
+	static void Dump();
+#else
+	static void Dump() {}
+#endif
+};
+
+#ifdef PROFILER
+
+// Marks the enclosing scope. Use PROFILE_ISR_ZONE inside interrupt handlers,
+// where interrupts are already off.
+
+class ProfileZone
+{
+  public:
+	ProfileZone(profileZones zone, bool isr) : zone(zone), isr(isr)
+	{
+		Profiler::Mark(zone, false, isr);
+	}
+	~ProfileZone()
+	{
+		Profiler::Mark(zone, true, isr);
+	}
+
+  private:
+	profileZones zone;
+	bool isr;
+};
+
+#define PROFILE_ZONE(z)			ProfileZone profileZone(profileZones::z, false)
+#define PROFILE_ISR_ZONE(z)		ProfileZone profileZone(profileZones::z, true)
+
+#else
+
+#define PROFILE_ZONE(z)
+#define PROFILE_ISR_ZONE(z)
+
+#endif // PROFILER
+
+#endif // profiler_h
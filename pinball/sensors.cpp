@@ -9,18 +9,21 @@
 
 #include "sensors.h"
 
+#include "adc.h"
 #include "debounce.h"
 #include "flippers.h"
 #include "game.h"
+#include "profiler.h"
 #include "messages.h"
 #include "sound.h"
+#include "spinner.h"
+#include "telemetry.h"
 #include "tests.h"
 
 #pragma region Macros ----------------------------------------------------------
 
 #define ALL_ROLLOVERS_ON	(rollovers[0] && rollovers[1] && rollovers[2])
-#define IS_BALL_LOST		(digitalRead(ballLostSensor))
-#define ON_OUTLANE			(!digitalRead(leftOutlaneSensor) || !digitalRead(rightOutlaneSensor))
+#define ON_OUTLANE			(!PIN_HIGH(leftOutlaneSensor) || !PIN_HIGH(rightOutlaneSensor))
 
 #pragma endregion --------------------------------------------------------------
 
@@ -32,7 +35,6 @@ AsyncDelay multipliersTimer;
 AsyncDelay skillShotTimer;
 AsyncDelay holdTimer;
 AsyncDelay holdScoreTimer;
-AsyncDelay spinnerCountTimer;
 
 #pragma endregion --------------------------------------------------------------
 
@@ -45,10 +47,10 @@ extern bool skillShotActive;
 extern bool holdActive;
 extern bool greasyActive;
 
-extern ulong playerScore;
-extern ulong lastScore;
-extern ulong greasyScore;
-extern ulong eobBonus;
+extern bcd playerScore;
+extern bcd lastScore;
+extern bcd greasyScore;
+extern bcd eobBonus;
 
 bool rollovers[3] = {false, false, false};
 
@@ -56,7 +58,7 @@ bool rollovers[3] = {false, false, false};
 
 #pragma region External functions ----------------------------------------------
 
-extern void incrementScore(ulong points);
+extern void incrementScore(bcd points);
 
 #pragma endregion --------------------------------------------------------------
 
@@ -127,15 +129,35 @@ void resetHold()
 
 #pragma endregion --------------------------------------------------------------
 
+#pragma region Sensor setup ----------------------------------------------------
+
+// Fast switches fire on the first edge and are then locked out for a while
+
+void registerSensors()
+{
+	Debounce::Register(rollover1Sensor, debouncePolicy::LEADING_EDGE, ROLLOVER_LOCKOUT);
+	Debounce::Register(rollover2Sensor, debouncePolicy::LEADING_EDGE, ROLLOVER_LOCKOUT);
+	Debounce::Register(rollover3Sensor, debouncePolicy::LEADING_EDGE, ROLLOVER_LOCKOUT);
+	Debounce::Register(rolloverSkillSensor, debouncePolicy::LEADING_EDGE, ROLLOVER_LOCKOUT);
+	Debounce::Register(leftOrbitSensor, debouncePolicy::LEADING_EDGE, ROLLOVER_LOCKOUT);
+	Debounce::Register(holdSensor, debouncePolicy::LEADING_EDGE, ANALOG_DEBOUNCE);
+}
+
+#pragma endregion --------------------------------------------------------------
+
 #pragma region Sensor check functions ------------------------------------------
 
 bool checkButtons()
 {
+	PROFILE_ZONE(CHECK_BUTTONS);
+
 	return RIGHT_BUTTON_ON || LEFT_BUTTON_ON;
 }
 
 bool checkOrbitSensor()
 {
+	PROFILE_ZONE(CHECK_ORBIT_SENSOR);
+
 	static bool result;
 	result = false;
 
@@ -143,7 +165,7 @@ bool checkOrbitSensor()
 		incrementScore(LEFT_ORBIT_POINTS);
 		if(greasyActive) {
 			Sound::Play(soundNames::FRYING);
-			eobBonus += GREASY_BONUS;
+			eobBonus = Bcd::Add(eobBonus, GREASY_BONUS);
 		} else {
 			Sound::Play(soundNames::DING);
 		}
@@ -156,6 +178,8 @@ bool checkOrbitSensor()
 
 bool checkRollovers()
 {
+	PROFILE_ZONE(CHECK_ROLLOVERS);
+
 	static bool result;
 	result = false;
 
@@ -185,6 +209,8 @@ bool checkRollovers()
 
 bool checkSkillShot()
 {
+	PROFILE_ZONE(CHECK_SKILL_SHOT);
+
 	static bool result;
 	result = false;
 
@@ -215,6 +241,8 @@ bool checkSkillShot()
 
 bool checkStopMagnet()
 {
+	PROFILE_ZONE(CHECK_STOP_MAGNET);
+
 	static bool result;
 	result = false;
 
@@ -242,7 +270,7 @@ bool checkStopMagnet()
 		if(holdTimer.isExpired()) {
 			resetHold();
 		} else {
-			if(analogRead(holdSensor) < HOLD_SENSOR_THRESHOLD) {
+			if(Adc::Read(holdSensor) < HOLD_SENSOR_THRESHOLD) {
 				if(holdScoreTimer.isExpired()) {
 					incrementScore(HOLD_ACTIVE_POINTS);
 					Msg.ShowScore();
@@ -258,57 +286,33 @@ bool checkStopMagnet()
 	return result;
 }
 
-#pragma region Enums -----------------------------------------------------------
-
-enum class spinnerStates
-{
-	IDLE = 0,
-	STREAK,
-};
-
-#pragma endregion --------------------------------------------------------------
-
-// MAX 36
-
-bool spinnerStreak = false;
 bool spinnerStreakSound = false;
-uint streakCounter = 0;
+
+// Vanes are captured by interrupt and scored by how fast the spinner turns
 
 bool checkSpinner()
 {
+	PROFILE_ZONE(CHECK_SPINNER);
+
 	static bool result;
 	result = false;
 
-	Debounce::Read(spinnerSensor, []() {
-		incrementScore(streakCounter >= BREAK_STREAK ? SPINNER_BREAK_POINTS : SPINNER_POINTS);
-		rotateRollovers();
-		showRolloverLeds();
-		Msg.ShowScore();
-		result = true;
+	while(Spinner::Read()) {
+		bool fast = Spinner::Rate() >= BREAK_SPIN_RATE;
 
-		if(!spinnerStreak) {
-			streakCounter++;
-			spinnerCountTimer.start(SPINNER_STREAK_TIMER, AsyncDelay::MILLIS);
-			spinnerStreak = true;
-		} else {
-			if(!spinnerCountTimer.isExpired()) {
-				streakCounter++;
-				if(!spinnerStreakSound && streakCounter >= BREAK_STREAK) {
-					Sound::Play(soundNames::GLASS);
-					spinnerStreakSound = true;
-				}
-				// Serial.print(streakCounter);
-				// Serial.print(" ");
-				spinnerCountTimer.restart();
-			}
+		incrementScore(fast ? SPINNER_BREAK_POINTS : SPINNER_POINTS);
+		rotateRollovers();
+		if(fast && !spinnerStreakSound) {
+			Sound::Play(soundNames::GLASS);
+			spinnerStreakSound = true;
 		}
-	});
+		result = true;
+	}
 
-	if(!result && spinnerStreak && spinnerCountTimer.isExpired()) {
-		// Serial.print("  Streak: ");
-		// Serial.println(streakCounter);
-		streakCounter = 0;
-		spinnerStreak = false;
+	if(result) {
+		showRolloverLeds();
+		Msg.ShowScore();
+	} else if(spinnerStreakSound && Spinner::Stopped(SPINNER_STREAK_TIMER)) {
 		spinnerStreakSound = false;
 	}
 
@@ -317,12 +321,12 @@ bool checkSpinner()
 
 bool checkOutlanes()
 {
+	PROFILE_ZONE(CHECK_OUTLANES);
+
 	static bool result;
 	result = false;
 
 	if(ON_OUTLANE) {
-		Flippers::Reset();
-		digitalWrite(stopMagnet, LOW);
 		incrementScore(OUTLANE_POINTS);
 		Sound::Play(soundNames::BUBBLES);
 		Msg.ShowScore();
@@ -334,12 +338,12 @@ bool checkOutlanes()
 
 bool checkBallLost()
 {
+	PROFILE_ZONE(CHECK_BALL_LOST);
+
 	static bool result;
 	result = false;
 
 	if(IS_BALL_LOST) {
-		Flippers::Reset();
-		digitalWrite(stopMagnet, LOW);
 		result = true;
 	}
 
@@ -348,14 +352,16 @@ bool checkBallLost()
 
 bool checkLaunch()
 {
+	PROFILE_ZONE(CHECK_LAUNCH);
+
 	static bool done;
-	static char *sensorName;
+	static bool byLaunchSensor;
 
 	done = false;
-	sensorName = "(none)";
+	byLaunchSensor = false;
 
-	if(analogRead(launchSensor) < LAUNCH_SENSOR_THRESHOLD) {
-		sensorName = "launch sensor";
+	if(Adc::Read(launchSensor) < LAUNCH_SENSOR_THRESHOLD) {
+		byLaunchSensor = true;
 		done = true;
 	} else {
 
@@ -385,8 +391,7 @@ bool checkLaunch()
 	}
 
 	if(done) {
-		Serial.print("  --> GameState changed by ");
-		Serial.println(sensorName);
+		Telemetry::Send(telemetryEvents::LAUNCHED, byLaunchSensor);
 	}
 
 	return done;
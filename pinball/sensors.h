@@ -10,6 +10,7 @@
 
 #include "pinball.h"
 
+void registerSensors();
 void resetRollovers();
 
 bool checkButtons();
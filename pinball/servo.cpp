@@ -11,14 +11,26 @@
 
 void Servo::CloseDoor()
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (int)childCommands::SERVO,
-		(int)servoCmd::CLOSE);
+	send(servoCmd::CLOSE);
 }
 
 void Servo::OpenDoor()
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (int)childCommands::SERVO,
-		(int)servoCmd::OPEN);
+	send(servoCmd::OPEN);
+}
+
+// Next command is sent whatever it is
+
+void Servo::Forget()
+{
+	shadow = SHADOW_UNKNOWN;
+}
+
+void Servo::send(servoCmd cmd)
+{
+	if(General::Changed(&shadow, (uint)cmd)) {
+		General::Cmd((byte)childCommands::SERVO, (int)cmd);
+	}
 }
 
 #pragma endregion --------------------------------------------------------------
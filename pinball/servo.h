@@ -9,12 +9,19 @@
 #define servo_h
 
 #include "pinball.h"
+#include "general.h"
 
 class Servo
 {
   public:
 	void CloseDoor();
 	void OpenDoor();
+	void Forget();
+
+  private:
+	void send(servoCmd cmd);
+
+	uint shadow = SHADOW_UNKNOWN;
 };
 
 #endif // servo_h
@@ -6,12 +6,13 @@
 // -----------------------------------------------------------------------------
 
 #include "sound.h"
+#include "general.h"
 
 #pragma region Methods ---------------------------------------------------------
 
 void Sound::Play(byte soundIndex)
 {
-	FtModules::I2C::Cmd(CHILD_ADDRESS, (int)childCommands::SOUND, soundIndex);
+	General::Cmd((byte)childCommands::SOUND, soundIndex);
 }
 
 #pragma endregion --------------------------------------------------------------
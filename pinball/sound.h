@@ -11,6 +11,7 @@
 #include <Arduino.h>
 #include <FtModules.h>
 #include "pb_child.h"
+#include "twi.h"
 
 class Sound
 {
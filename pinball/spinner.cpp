@@ -0,0 +1,133 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Interrupt-driven spinner capture
+// Rubem Pechansky 2021
+
+// A pin change interrupt timestamps every vane that reaches spinnerSensor, so
+// none are lost while the loop is busy. Read() takes them out of the buffer in
+// order and keeps a running average of the time between vanes.
+
+// -----------------------------------------------------------------------------
+
+#include "spinner.h"
+#include "game.h"
+
+#pragma region Hardware constants ----------------------------------------------
+
+#define SPINNER_PORT_BIT		(spinnerSensor - A0)		// PINC, PCINT8 + n
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Variables -------------------------------------------------------
+
+volatile ulong vaneTimes[SPINNER_BUFFER];
+volatile byte vaneHead = 0;
+volatile byte vaneOverflows = 0;
+byte vaneTail = 0;
+
+ulong lastVaneUs;
+ulong vaneIntervalUs = 0;				// Running average, 0 = just started
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Interrupt handler -----------------------------------------------
+
+// Vanes pull the input low. A falling edge counts only if the input had been
+// high for SPINNER_LOCKOUT, so bounce is ignored when a vane arrives and when
+// it leaves, however slowly the spinner turns.
+
+ISR(PCINT1_vect)
+{
+	static bool wasHigh = true;
+	static ulong highSinceUs = 0;
+
+	ulong us = micros();
+
+	if(PINC & bit(SPINNER_PORT_BIT)) {
+		highSinceUs = us;				// Also restarts after a missed low glitch
+		wasHigh = true;
+		return;
+	}
+
+	if(!wasHigh) {						// A high glitch too short to see
+		return;
+	}
+	wasHigh = false;
+	if(us - highSinceUs < SPINNER_LOCKOUT * 1000UL) {
+		return;
+	}
+
+	byte next = (vaneHead + 1) & (SPINNER_BUFFER - 1);
+	if(next == vaneTail) {
+		vaneOverflows++;
+		return;
+	}
+	vaneTimes[vaneHead] = us;
+	vaneHead = next;
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Methods ---------------------------------------------------------
+
+void Spinner::Init()
+{
+	PCMSK1 |= bit(PCINT8 + SPINNER_PORT_BIT);
+	PCIFR |= bit(PCIF1);
+	PCICR |= bit(PCIE1);
+}
+
+// Takes the next vane out of the buffer; false if there is none
+
+bool Spinner::Read()
+{
+	if(vaneTail == vaneHead) {
+		return false;
+	}
+
+	ulong us = vaneTimes[vaneTail];
+	vaneTail = (vaneTail + 1) & (SPINNER_BUFFER - 1);
+
+	ulong interval = us - lastVaneUs;
+	lastVaneUs = us;
+
+	if(interval > SPINNER_STREAK_TIMER * 1000UL) {
+		vaneIntervalUs = 0;
+	} else if(!vaneIntervalUs) {
+		vaneIntervalUs = interval;
+	} else {
+		vaneIntervalUs = (3 * vaneIntervalUs + interval) / 4;
+	}
+
+	return true;
+}
+
+// Forgets the vanes caught while nothing was reading them, such as a spinner
+// still coasting after the ball was lost
+
+void Spinner::Flush()
+{
+	noInterrupts();
+	vaneTail = vaneHead;
+	interrupts();
+	vaneIntervalUs = 0;
+}
+
+// Revolutions per second as of the last vane read; 0 on the first one
+
+uint Spinner::Rate()
+{
+	return vaneIntervalUs ? 1000000UL / (vaneIntervalUs * SPINNER_VANES) : 0;
+}
+
+bool Spinner::Stopped(uint ms)
+{
+	return micros() - lastVaneUs > ms * 1000UL;
+}
+
+byte Spinner::Overflows()
+{
+	return vaneOverflows;
+}
+
+#pragma endregion --------------------------------------------------------------
@@ -0,0 +1,28 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Interrupt-driven spinner capture
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#ifndef spinner_h
+#define spinner_h
+
+#include "pinball.h"
+
+#define SPINNER_BUFFER			8		// Vane timestamps, power of 2
+#define SPINNER_LOCKOUT			4		// ms high before the next vane counts
+#define SPINNER_VANES			1		// Sensor pulses per revolution
+
+class Spinner
+{
+  public:
+	static void Init();
+	static bool Read();
+	static void Flush();
+	static uint Rate();
+	static bool Stopped(uint ms);
+	static byte Overflows();
+};
+
+#endif // spinner_h
@@ -0,0 +1,38 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Cooperative tasks
+// Rubem Pechansky 2021
+
+// Stackless tasks in the style of protothreads. A task is a void function
+// called once per loop pass; it picks up where it last waited and returns to
+// the main loop instead of blocking. Locals do not survive a wait.
+
+// -----------------------------------------------------------------------------
+
+#ifndef task_h
+#define task_h
+
+#include <AsyncDelay.h>
+
+#include "Simpletypes.h"
+
+struct task {
+	uint line;
+	AsyncDelay timer;
+};
+
+#define TASK_BEGIN(t)				switch((t).line) { case 0:
+#define TASK_END(t)					} (t).line = 0
+#define TASK_RESET(t)				((t).line = 0)
+
+// Return to the main loop until cond holds
+
+#define TASK_WAIT_UNTIL(t, cond)	(t).line = __LINE__; case __LINE__: \
+									if(!(cond)) return
+
+// Return to the main loop for ms milliseconds
+
+#define TASK_SLEEP(t, ms)			(t).timer.start(ms, AsyncDelay::MILLIS); \
+									TASK_WAIT_UNTIL(t, (t).timer.isExpired())
+
+#endif // task_h
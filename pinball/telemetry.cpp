@@ -0,0 +1,73 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Binary serial telemetry
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#include "telemetry.h"
+
+#pragma region Variables -------------------------------------------------------
+
+ulong telemetrySent = 0;
+ulong telemetryDropped = 0;
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Public methods --------------------------------------------------
+
+void Telemetry::Send(telemetryEvents id)
+{
+	send(id, NULL, 0);
+}
+
+void Telemetry::Send(telemetryEvents id, byte arg)
+{
+	send(id, &arg, 1);
+}
+
+ulong Telemetry::Sent()
+{
+	return telemetrySent;
+}
+
+ulong Telemetry::Dropped()
+{
+	return telemetryDropped;
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Private methods -------------------------------------------------
+
+void Telemetry::send(telemetryEvents id, const byte *payload, byte n)
+{
+	byte frame[TELEMETRY_PAYLOAD + TELEMETRY_OVERHEAD];
+	byte length = n + TELEMETRY_OVERHEAD;
+	uint now = millis();
+	byte sum = 0;
+
+	if(n > TELEMETRY_PAYLOAD || Serial.availableForWrite() < length) {
+		telemetryDropped++;
+		return;
+	}
+
+	frame[0] = TELEMETRY_SYNC;
+	frame[1] = (byte)id;
+	frame[2] = lowByte(now);
+	frame[3] = highByte(now);
+	frame[4] = n;
+	for(byte i = 0; i < n; i++) {
+		frame[5 + i] = payload[i];
+	}
+
+	for(byte i = 1; i < length - 1; i++) {
+		sum += frame[i];
+	}
+	frame[length - 1] = sum;
+
+	Serial.write(frame, length);
+	telemetrySent++;
+}
+
+#pragma endregion --------------------------------------------------------------
@@ -0,0 +1,43 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Binary serial telemetry
+// Rubem Pechansky 2021
+
+// Game events go out as short binary frames instead of text, and only if they
+// fit in the serial TX buffer: a frame is never waited for, it is dropped and
+// counted. host/decode.cpp turns the frames back into readable lines.
+
+// Frame: TELEMETRY_SYNC, event id, millis() & 0xffff (LSB first), payload
+// length, payload, sum of all bytes after the sync byte
+
+// -----------------------------------------------------------------------------
+
+#ifndef telemetry_h
+#define telemetry_h
+
+#include "pinball.h"
+
+#define TELEMETRY_SYNC			0xa5	// Never part of the text output
+#define TELEMETRY_PAYLOAD		4		// Longest payload, in bytes
+#define TELEMETRY_OVERHEAD		6		// Frame bytes besides the payload
+
+enum class telemetryEvents : byte
+{
+	GAME_STATE = 1,		// gameStates value
+	LAUNCHED,			// 1 if seen by the launch sensor, 0 by another sensor
+	FEEDER_TIMEOUT,
+};
+
+class Telemetry
+{
+  public:
+	static void Send(telemetryEvents id);
+	static void Send(telemetryEvents id, byte arg);
+	static ulong Sent();
+	static ulong Dropped();
+
+  private:
+	static void send(telemetryEvents id, const byte *payload, byte n);
+};
+
+#endif // telemetry_h
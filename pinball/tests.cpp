@@ -10,7 +10,10 @@
 
 #include "tests.h"
 #include "pinball.h"
+#include "adc.h"
 #include "display.h"
+#include "general.h"
+#include "inputs.h"
 #include "sound.h"
 #include "servo.h"
 
@@ -36,11 +39,19 @@ uint nSound = 0;
 uint nLedTest = 0;
 Servo servoTest;
 
-const char *names[] = {
+#define SOUND_NAME_LENGTH		7
+#define STATE_NAME_LENGTH		14
+
+const char names[][SOUND_NAME_LENGTH + 1] PROGMEM = {
 	"DING", "DRAIN", "GLASS", "CLANG", "FAUCET", "CRASH",
 	"FRYING", "BUBBLES", "CABINET", "SHAKE", "BELL"
 };
 
+const char stateNames[][STATE_NAME_LENGTH + 1] PROGMEM = {
+	"Game start", "Ball start", "Launching", "Playing", "No more points",
+	"Ball lost", "Save ball", "Next ball", "Ball near home", "Game over"
+};
+
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Public methods --------------------------------------------------
@@ -51,6 +62,7 @@ void Tests::Leds()
 	leds.Off((childLeds)nLedTest);
 	nLedTest = nLedTest == NLEDS - 1 ? 0 : nLedTest + 1;
 	leds.On((childLeds)nLedTest);
+	General::Flush();
 	delay(500);
 	Display::Clear();
 	Display::U2s(displayBuffer, nLedTest);
@@ -65,9 +77,11 @@ void Tests::Sounds()
 		delay(100);
 	} else if(LEFT_BUTTON_ON) {
 		Sound::Play(nSound);
+		General::Flush();
 	}
 	while(LEFT_BUTTON_ON || RIGHT_BUTTON_ON) {
 		delay(1);
+		Inputs::Read();
 	}
 	delay(5);
 }
@@ -76,110 +90,76 @@ void Tests::Inputs()
 {
 	// Digital sensors
 
-	testDigitalSensor(leftButton, &leftButtonState, "Left button");
-	testDigitalSensor(rightButton, &rightButtonState, "Right button");
-	testDigitalSensor(leftOutlaneSensor, &leftOutlaneSensorState, "Left outlane");
-	testDigitalSensor(rightOutlaneSensor, &rightOutlaneSensorState, "Right outlane");
-	testDigitalSensor(rolloverSkillSensor, &rolloverSkillSensorState, "Skill shot rollover");
-	testDigitalSensor(rollover3Sensor, &rollover3SensorState, "Rollover 3");
-	testDigitalSensor(rollover2Sensor, &rollover2SensorState, "Rollover 2");
-	testDigitalSensor(rollover1Sensor, &rollover1SensorState, "Rollover 1");
-	testDigitalSensor(ballLostSensor, &ballLostSensorState, "Ball lost");
-	testDigitalSensor(feederHomeSensor, &feederHomeSensorState, "Feeder at home");
-	testDigitalSensor(ballNearHomeSensor, &ballNearHomeSensorState, "Ball near home");
-	testDigitalSensor(spinnerSensor, &spinnerSensorState, "Spinner");
-	testDigitalSensor(leftOrbitSensor, &leftOrbitSensorState, "Left orbit");
+	testDigitalSensor(leftButton, &leftButtonState, F("Left button"));
+	testDigitalSensor(rightButton, &rightButtonState, F("Right button"));
+	testDigitalSensor(leftOutlaneSensor, &leftOutlaneSensorState, F("Left outlane"));
+	testDigitalSensor(rightOutlaneSensor, &rightOutlaneSensorState, F("Right outlane"));
+	testDigitalSensor(rolloverSkillSensor, &rolloverSkillSensorState, F("Skill shot rollover"));
+	testDigitalSensor(rollover3Sensor, &rollover3SensorState, F("Rollover 3"));
+	testDigitalSensor(rollover2Sensor, &rollover2SensorState, F("Rollover 2"));
+	testDigitalSensor(rollover1Sensor, &rollover1SensorState, F("Rollover 1"));
+	testDigitalSensor(ballLostSensor, &ballLostSensorState, F("Ball lost"));
+	testDigitalSensor(feederHomeSensor, &feederHomeSensorState, F("Feeder at home"));
+	testDigitalSensor(ballNearHomeSensor, &ballNearHomeSensorState, F("Ball near home"));
+	testDigitalSensor(spinnerSensor, &spinnerSensorState, F("Spinner"));
+	testDigitalSensor(leftOrbitSensor, &leftOrbitSensorState, F("Left orbit"));
 
 	// Analog sensors
 
-	testAnalogSensor(holdSensor, MIN_ANALOG_THRESHOLD, HOLD_SENSOR_THRESHOLD, "Hold");
-	testAnalogSensor(launchSensor, MIN_ANALOG_THRESHOLD, LAUNCH_SENSOR_THRESHOLD, "Ball launched");
+	testAnalogSensor(holdSensor, MIN_ANALOG_THRESHOLD, HOLD_SENSOR_THRESHOLD, F("Hold"));
+	testAnalogSensor(launchSensor, MIN_ANALOG_THRESHOLD, LAUNCH_SENSOR_THRESHOLD, F("Ball launched"));
 }
 
 void Tests::AnalogSensors()
 {
-	Serial.print("Hold: ");
-	Serial.print(analogRead(holdSensor));
+	Serial.print(F("Hold: "));
+	Serial.print(Adc::Read(holdSensor));
 	delay(50);
-	Serial.print(" / Launch: ");
-	Serial.println(analogRead(launchSensor));
+	Serial.print(F(" / Launch: "));
+	Serial.println(Adc::Read(launchSensor));
 	delay(50);
 }
 
 void Tests::Servo()
 {
 	servoTest.OpenDoor();
+	General::Flush();
 	delay(1000);
 	servoTest.CloseDoor();
+	General::Flush();
 	delay(1000);
 }
 
-void Tests::GameState(gameStates state)
+const __FlashStringHelper *Tests::StateName(gameStates state)
 {
-	Serial.println("----------------------------");
-	Serial.print("gameState: ");
-
-	switch(state) {
-		case gameStates::GAME_START:
-			Serial.println("Game start");
-			return;
-		case gameStates::BALL_START:
-			Serial.println("Ball start");
-			return;
-		case gameStates::LAUNCHING:
-			Serial.println("Launching");
-			return;
-		case gameStates::PLAYING:
-			Serial.println("Playing");
-			return;
-		case gameStates::NO_MORE_POINTS:
-			Serial.println("No more points");
-			return;
-		case gameStates::BALL_LOST:
-			Serial.println("Ball lost");
-			return;
-		case gameStates::SAVE_BALL:
-			Serial.println("Save ball");
-			return;
-		case gameStates::NEXT_BALL:
-			Serial.println("Next ball");
-			return;
-		case gameStates::BALL_NEAR_HOME:
-			Serial.println("Ball near home");
-			return;
-		case gameStates::GAME_OVER:
-			Serial.println("Game over");
-			return;
-		default:
-			Serial.print("Unknown: ");
-			Serial.println((int)state);
-			return;
-	}
+	uint n = (int)state - (int)gameStates::GAME_START;
+
+	return n < NUMITEMS(stateNames) ? (const __FlashStringHelper *)stateNames[n] : NULL;
 }
 
 #pragma endregion --------------------------------------------------------------
 
 #pragma region Private methods -------------------------------------------------
 
-void Tests::testDigitalSensor(byte sensor, bool *last, char *name)
+void Tests::testDigitalSensor(byte sensor, bool *last, const __FlashStringHelper *name)
 {
 	bool state = digitalRead(sensor);
 
 	if(state != *last) {
 		Serial.print(name);
-		Serial.print(": ");
+		Serial.print(F(": "));
 		Serial.println(state);
 		*last = state;
 	}
 }
 
-void Tests::testAnalogSensor(byte sensor, uint min, uint max, char *name)
+void Tests::testAnalogSensor(byte sensor, uint min, uint max, const __FlashStringHelper *name)
 {
-	uint value = analogRead(sensor);
+	uint value = Adc::Read(sensor);
 
 	if(value >= min && value < max) {
 		Serial.print(name);
-		Serial.print(": ");
+		Serial.print(F(": "));
 		Serial.println(value);
 		delay(50);
 	}
@@ -187,10 +167,10 @@ void Tests::testAnalogSensor(byte sensor, uint min, uint max, char *name)
 
 void Tests::displaySound(byte n)
 {
-	Serial.print("Sound #");
+	Serial.print(F("Sound #"));
 	Serial.print(n);
-	Serial.print(": ");
-	Serial.println(names[n - 1]);
+	Serial.print(F(": "));
+	Serial.println((const __FlashStringHelper *)names[n - 1]);
 	Display::Stop();
 	Display::U2s(displayBuffer, n);
 	Display::Show(displayBuffer);
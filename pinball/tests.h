@@ -18,11 +18,11 @@ class Tests
 	static void Inputs();
 	static void AnalogSensors();
 	static void Servo();
-	static void GameState(gameStates state);
+	static const __FlashStringHelper *StateName(gameStates state);
 
   private:
-	static void testDigitalSensor(byte sensor, bool *last, char *name);
-	static void testAnalogSensor(byte sensor, uint min, uint max, char *name);
+	static void testDigitalSensor(byte sensor, bool *last, const __FlashStringHelper *name);
+	static void testAnalogSensor(byte sensor, uint min, uint max, const __FlashStringHelper *name);
 	static void displaySound(byte nSound);
 };
 
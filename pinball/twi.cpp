@@ -0,0 +1,449 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Interrupt-driven I²C master
+// Rubem Pechansky 2021
+
+// Commands are copied into a ring and sent by the TWI interrupt handler, so
+// Cmd() returns at once instead of waiting ~0.1 ms per byte like Wire does.
+// Consecutive commands are chained with repeated starts. When the ring is
+// full new commands are dropped and counted.
+
+// A read is queued like a command and its reply kept until Reply() takes it;
+// only one may be pending at a time.
+
+// A command that is not acknowledged is retried a few times, then dropped.
+// Update() watches the bus from the main loop: if a byte takes too long, as
+// when a device holds SDA low, the bus is cleared by clocking SCL by hand and
+// the command is retried. Errors are counted per device. Nothing here waits
+// for the bus, so a faulty device cannot stall the main loop.
+
+// The child stretches SCL while its interrupts are off, ~1.04 ms per byte it
+// sends the DFPlayer at 9600 baud. TWI_TIMEOUT is above a whole DFPlayer
+// command (DFPLAYER_CMD_US on the child), so a healthy child is never taken
+// for a stuck bus and sent a packet twice.
+
+// Replaces Wire and its five 32-byte buffers; Wire must not be used.
+
+// -----------------------------------------------------------------------------
+
+#include "twi.h"
+#include "profiler.h"
+
+#pragma region Hardware constants ----------------------------------------------
+
+#define TWI_FREQ				100000L
+#define TWI_BUFFER				128		// Power of two
+#define TWI_MASK				(TWI_BUFFER - 1)
+#define TWI_RETRIES				3		// Tries per command
+#define TWI_TIMEOUT				12000	// Longest a byte may take, µs
+#define TWI_STOP_SPINS			100		// Wait for a stop to go out
+#define TWI_CLEAR_CLOCKS		9
+#define TWI_HALF_CLOCK			5		// µs
+#define TWI_READ_FLAG			0x80	// In the ring's address byte
+
+// Control register values
+
+#define TWCR_START				(bit(TWEN) | bit(TWIE) | bit(TWINT) | bit(TWSTA))
+#define TWCR_NEXT				(bit(TWEN) | bit(TWIE) | bit(TWINT))
+#define TWCR_STOP				(bit(TWEN) | bit(TWINT) | bit(TWSTO))
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Variables -------------------------------------------------------
+
+// Each command takes its address, its length and its data; a read takes only
+// its address, with TWI_READ_FLAG, and the length of the reply
+
+byte twiRing[TWI_BUFFER];
+byte twiHead = 0;						// Where the next command goes
+volatile byte twiTail = 0;				// Command being sent
+volatile byte twiUsed = 0;				// Bytes in the ring
+volatile byte twiCount = 0;				// Commands in the ring
+volatile bool twiBusy = false;
+volatile byte twiSent;					// Data bytes of the current command
+volatile byte twiTries = 0;				// Failed tries of the current command
+volatile byte twiProgress = 0;			// Starts and interrupts so far
+uint twiDropped = 0;
+uint twiRecoveries = 0;
+
+byte twiReply[TWI_REPLY_LENGTH];
+volatile bool twiReading = false;		// Read queued or in progress
+volatile bool twiReplied = false;		// Reply waiting for Reply()
+
+// Watchdog
+
+byte twiLastProgress = 0;
+ulong twiLastUs = 0;
+
+struct twiDevice {
+	byte address;
+	uint errors;						// Failed tries
+	uint drops;							// Commands given up or not queued
+};
+
+twiDevice twiDevices[TWI_DEVICES];
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Interrupt handler -----------------------------------------------
+
+static twiDevice *twiFind(byte address)
+{
+	for(byte i = 0; i < TWI_DEVICES; i++) {
+		if(twiDevices[i].address == address || twiDevices[i].address == 0) {
+			twiDevices[i].address = address;
+			return &twiDevices[i];
+		}
+	}
+	return NULL;
+}
+
+static void twiError(byte address)
+{
+	twiDevice *device = twiFind(address);
+
+	if(device) {
+		device->errors++;
+	}
+}
+
+// Must run with interrupts off
+
+static void twiDrop(byte address)
+{
+	twiDevice *device = twiFind(address);
+
+	if(device) {
+		device->drops++;
+	}
+	twiDropped++;
+}
+
+// The current command is done, or given up: start the next one or release the
+// bus
+
+static void twiNext()
+{
+	bool read = twiRing[twiTail] & TWI_READ_FLAG;
+	byte n = read ? 2 : twiRing[(twiTail + 1) & TWI_MASK] + 2;
+
+	if(read) {
+		twiReading = false;
+	}
+
+	twiTail = (twiTail + n) & TWI_MASK;
+	twiUsed -= n;
+	twiCount--;
+	twiTries = 0;
+
+	if(twiCount) {
+		TWCR = TWCR_START;
+	} else {
+		TWCR = TWCR_STOP;
+		twiBusy = false;
+	}
+}
+
+// The current command failed: try it again from its start, or drop it
+
+static void twiRetry()
+{
+	byte address = twiRing[twiTail] & ~TWI_READ_FLAG;
+
+	twiError(address);
+
+	if(++twiTries < TWI_RETRIES) {
+		TWCR = TWCR_START;
+	} else {
+		twiDrop(address);
+		twiNext();
+	}
+}
+
+// Acknowledge every byte of a reply but the last
+
+static byte twiAck()
+{
+	return twiSent + 1 < twiRing[(twiTail + 1) & TWI_MASK] ? bit(TWEA) : 0;
+}
+
+ISR(TWI_vect)
+{
+	byte address = twiRing[twiTail];
+
+	twiProgress++;
+
+	switch(TW_STATUS) {
+
+		case TW_START:
+		case TW_REP_START:
+			twiSent = 0;
+			TWDR = (address & ~TWI_READ_FLAG) << 1 | (address & TWI_READ_FLAG ? TW_READ : TW_WRITE);
+			TWCR = TWCR_NEXT;
+			break;
+
+		case TW_MR_SLA_ACK:
+			TWCR = TWCR_NEXT | twiAck();
+			break;
+
+		case TW_MR_DATA_ACK:
+		case TW_MR_DATA_NACK:
+			twiReply[twiSent++] = TWDR;
+			if(twiSent < twiRing[(twiTail + 1) & TWI_MASK]) {
+				TWCR = TWCR_NEXT | twiAck();
+			} else {
+				twiReplied = true;
+				twiNext();
+			}
+			break;
+
+		case TW_MT_SLA_ACK:
+		case TW_MT_DATA_ACK:
+			if(twiSent < twiRing[(twiTail + 1) & TWI_MASK]) {
+				TWDR = twiRing[(twiTail + 2 + twiSent++) & TWI_MASK];
+				TWCR = TWCR_NEXT;
+			} else {
+				twiNext();
+			}
+			break;
+
+		case TW_MT_ARB_LOST:
+			TWCR = TWCR_START;
+			break;
+
+		default:						// Not acknowledged or bus error
+			twiRetry();
+			break;
+	}
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Bus recovery ----------------------------------------------------
+
+// With the TWI off, clock SCL until whoever holds SDA lets go, then send a
+// stop. Takes at most ~0.1 ms.
+
+static void twiClearBus()
+{
+	TWCR = 0;
+
+	pinMode(SDA, INPUT_PULLUP);
+	for(byte i = 0; i < TWI_CLEAR_CLOCKS && !digitalRead(SDA); i++) {
+		digitalWrite(SCL, LOW);
+		pinMode(SCL, OUTPUT);
+		delayMicroseconds(TWI_HALF_CLOCK);
+		pinMode(SCL, INPUT_PULLUP);
+		delayMicroseconds(TWI_HALF_CLOCK);
+	}
+
+	digitalWrite(SDA, LOW);
+	pinMode(SDA, OUTPUT);
+	delayMicroseconds(TWI_HALF_CLOCK);
+	pinMode(SDA, INPUT_PULLUP);
+
+	TWCR = bit(TWEN);
+}
+
+#pragma endregion --------------------------------------------------------------
+
+#pragma region Methods ---------------------------------------------------------
+
+void Twi::Init()
+{
+	// Internal pull-ups, as Wire does
+
+	digitalWrite(SDA, HIGH);
+	digitalWrite(SCL, HIGH);
+
+	TWSR = 0;
+	TWBR = (F_CPU / TWI_FREQ - 16) / 2;
+	TWCR = bit(TWEN);
+}
+
+// Called once per loop pass
+
+void Twi::Update()
+{
+	ulong us = micros();
+
+	if(!twiBusy || twiProgress != twiLastProgress) {
+		twiLastProgress = twiProgress;
+		twiLastUs = us;
+		return;
+	}
+
+	if(us - twiLastUs < TWI_TIMEOUT) {
+		return;
+	}
+
+	noInterrupts();
+	twiClearBus();
+	twiRecoveries++;
+	twiRetry();
+	interrupts();
+
+	twiLastUs = us;
+}
+
+// An entry of n bytes was added at the head: start sending if the bus is idle
+
+static void twiQueued(byte n)
+{
+	noInterrupts();
+	twiUsed += n;
+	twiCount++;
+	if(!twiBusy) {
+		byte spins = TWI_STOP_SPINS;
+
+		twiBusy = true;
+		twiProgress++;
+		while((TWCR & bit(TWSTO)) && --spins);		// Last stop still going out
+		TWCR = TWCR_START;
+	}
+	interrupts();
+}
+
+// Only the interrupt handler frees space, so the copy needs no locking
+
+bool Twi::Send(byte address, const byte *data, byte n)
+{
+	PROFILE_ZONE(TWI_SEND);
+
+	if(n > TWI_CMD_LENGTH || twiUsed + n + 2 > TWI_BUFFER) {
+		noInterrupts();
+		twiDrop(address);
+		interrupts();
+		return false;
+	}
+
+	twiRing[twiHead] = address;
+	twiRing[(twiHead + 1) & TWI_MASK] = n;
+	for(byte i = 0; i < n; i++) {
+		twiRing[(twiHead + 2 + i) & TWI_MASK] = data[i];
+	}
+	twiHead = (twiHead + n + 2) & TWI_MASK;
+
+	twiQueued(n + 2);
+	return true;
+}
+
+// Queues a read of n bytes; false if one is still pending or it does not fit
+
+bool Twi::Request(byte address, byte n)
+{
+	if(twiReading || twiReplied || n == 0 || n > TWI_REPLY_LENGTH) {
+		return false;
+	}
+
+	if(twiUsed + 2 > TWI_BUFFER) {
+		noInterrupts();
+		twiDrop(address);
+		interrupts();
+		return false;
+	}
+
+	twiRing[twiHead] = address | TWI_READ_FLAG;
+	twiRing[(twiHead + 1) & TWI_MASK] = n;
+	twiHead = (twiHead + 2) & TWI_MASK;
+
+	twiReading = true;
+	twiQueued(2);
+	return true;
+}
+
+// Takes the first n bytes of the reply; false until there is one. A read that
+// is given up never replies and counts as a drop.
+
+bool Twi::Reply(byte *data, byte n)
+{
+	if(!twiReplied) {
+		return false;
+	}
+
+	for(byte i = 0; i < n && i < TWI_REPLY_LENGTH; i++) {
+		data[i] = twiReply[i];
+	}
+	twiReplied = false;
+	return true;
+}
+
+void Twi::Cmd(byte address, byte cmd)
+{
+	Send(address, &cmd, 1);
+}
+
+void Twi::Cmd(byte address, byte cmd, int arg1)
+{
+	byte data[] = {cmd, (byte)arg1};
+	Send(address, data, sizeof data);
+}
+
+void Twi::Cmd(byte address, byte cmd, int arg1, int arg2)
+{
+	byte data[] = {cmd, (byte)arg1, (byte)arg2};
+	Send(address, data, sizeof data);
+}
+
+void Twi::Cmd(byte address, byte cmd, int arg1, int arg2, int arg3)
+{
+	byte data[] = {cmd, (byte)arg1, (byte)arg2, (byte)arg3};
+	Send(address, data, sizeof data);
+}
+
+void Twi::Cmd(byte address, byte cmd, char *str)
+{
+	byte data[TWI_CMD_LENGTH];
+	byte n = 0;
+
+	data[n++] = cmd;
+	while(*str && n < TWI_CMD_LENGTH) {
+		data[n++] = *str++;
+	}
+	Send(address, data, n);
+}
+
+byte Twi::Depth()
+{
+	return twiCount;
+}
+
+uint Twi::Dropped()
+{
+	return twiDropped;
+}
+
+// Commands to a device that never made it. Wrappers that skip repeated
+// commands must forget what they sent when this changes.
+
+uint Twi::Drops(byte address)
+{
+	uint drops = 0;
+
+	noInterrupts();
+	for(byte i = 0; i < TWI_DEVICES; i++) {
+		if(twiDevices[i].address == address) {
+			drops = twiDevices[i].drops;
+		}
+	}
+	interrupts();
+
+	return drops;
+}
+
+uint Twi::Errors(byte address)
+{
+	for(byte i = 0; i < TWI_DEVICES; i++) {
+		if(twiDevices[i].address == address) {
+			return twiDevices[i].errors;
+		}
+	}
+	return 0;
+}
+
+uint Twi::Recoveries()
+{
+	return twiRecoveries;
+}
+
+#pragma endregion --------------------------------------------------------------
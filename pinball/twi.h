@@ -0,0 +1,40 @@
+// -----------------------------------------------------------------------------
+
+// Dirty Dishes pinball: Interrupt-driven I²C master
+// Rubem Pechansky 2021
+
+// -----------------------------------------------------------------------------
+
+#ifndef twi_h
+#define twi_h
+
+#include <Arduino.h>
+#include <util/twi.h>
+
+#include "Simpletypes.h"
+
+#define TWI_CMD_LENGTH			32		// Longest command, in bytes
+#define TWI_DEVICES				4		// Devices with error counters
+#define TWI_REPLY_LENGTH		4		// Longest read, in bytes
+
+class Twi
+{
+  public:
+	static void Init();
+	static void Update();
+	static bool Send(byte address, const byte *data, byte n);
+	static void Cmd(byte address, byte cmd);
+	static void Cmd(byte address, byte cmd, int arg1);
+	static void Cmd(byte address, byte cmd, int arg1, int arg2);
+	static void Cmd(byte address, byte cmd, int arg1, int arg2, int arg3);
+	static void Cmd(byte address, byte cmd, char *str);
+	static bool Request(byte address, byte n);
+	static bool Reply(byte *data, byte n);
+	static byte Depth();
+	static uint Dropped();
+	static uint Drops(byte address);
+	static uint Errors(byte address);
+	static uint Recoveries();
+};
+
+#endif // twi_h